@@ -0,0 +1,183 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace experimentgl {
+
+namespace {
+
+// Number of buckets in each series' histogram.
+const int kHistogramBuckets = 20;
+
+double elapsed_ms(std::chrono::steady_clock::time_point from,
+                  std::chrono::steady_clock::time_point to) {
+  return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+// Nearest-rank percentile of an already sorted, non-empty vector.
+double percentile(const std::vector<double>& sorted, double p) {
+  size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+  return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+void write_series(std::ofstream& out, const std::string& name, std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  double sum = 0;
+  for (double v : values) {
+    sum += v;
+  }
+  double lo = values.front();
+  double hi = values.back();
+  double width = (hi - lo) / kHistogramBuckets;
+  std::vector<long> counts(kHistogramBuckets, 0);
+  for (double v : values) {
+    int bucket = width > 0 ? static_cast<int>((v - lo) / width) : 0;
+    ++counts[std::min(bucket, kHistogramBuckets - 1)];
+  }
+
+  out << "    \"" << name << "\": {\n"
+      << "      \"count\": " << values.size() << ",\n"
+      << "      \"min\": " << lo << ",\n"
+      << "      \"max\": " << hi << ",\n"
+      << "      \"mean\": " << sum / values.size() << ",\n"
+      << "      \"p50\": " << percentile(values, 50) << ",\n"
+      << "      \"p95\": " << percentile(values, 95) << ",\n"
+      << "      \"p99\": " << percentile(values, 99) << ",\n"
+      << "      \"histogram\": {\"lo\": " << lo << ", \"bucket_width\": " << width
+      << ", \"counts\": [";
+  for (int i = 0; i < kHistogramBuckets; ++i) {
+    out << (i ? ", " : "") << counts[i];
+  }
+  out << "]}\n    }";
+}
+
+} // anonymous namespace.
+
+Benchmark::Benchmark(const BenchmarkOptions& options) : options_(options) {}
+
+std::unique_ptr<Benchmark> Benchmark::Create(const BenchmarkOptions& options) {
+  if (options.frames <= 0 || options.warmup < 0) {
+    std::cout << "Invalid benchmark frame counts" << std::endl;
+    return nullptr;
+  }
+  std::unique_ptr<Benchmark> b(new Benchmark(options));
+  for (GlQuery& query : b->queries_) {
+    query = GlQuery::Create();
+  }
+  std::fill(b->query_frame_, b->query_frame_ + kQueryRing, -1);
+  b->BeginFrame();
+  return b;
+}
+
+void Benchmark::BeginFrame() {
+  frame_start_ = std::chrono::steady_clock::now();
+  if (Done()) {
+    return;
+  }
+  int slot = frame_ % kQueryRing;
+  // The slot was last used kQueryRing frames ago, so this rarely waits.
+  if (query_frame_[slot] >= 0) {
+    CollectQuery(slot, /*wait=*/true);
+  }
+  glBeginQuery(GL_TIME_ELAPSED, queries_[slot].get());
+  query_frame_[slot] = frame_;
+  query_active_ = true;
+}
+
+void Benchmark::BeginSwap() {
+  swap_start_ = std::chrono::steady_clock::now();
+  if (query_active_) {
+    glEndQuery(GL_TIME_ELAPSED);
+    query_active_ = false;
+  }
+}
+
+void Benchmark::EndSwap() {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  Record("frame_ms", frame_, elapsed_ms(frame_start_, now));
+  Record("cpu_ms", frame_, elapsed_ms(frame_start_, swap_start_));
+  Record("swap_ms", frame_, elapsed_ms(swap_start_, now));
+  ++frame_;
+  // Pick up whatever finished without waiting on the GPU.
+  for (int slot = 0; slot < kQueryRing; ++slot) {
+    if (query_frame_[slot] >= 0 && query_frame_[slot] < frame_) {
+      CollectQuery(slot, /*wait=*/false);
+    }
+  }
+  BeginFrame();
+}
+
+bool Benchmark::CollectQuery(int slot, bool wait) {
+  if (!wait) {
+    int available = 0;
+    glGetQueryObjectiv(queries_[slot].get(), GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+      return false;
+    }
+  }
+  GLuint64 ns = 0;
+  glGetQueryObjectui64v(queries_[slot].get(), GL_QUERY_RESULT, &ns);
+  Record("gpu_ms", query_frame_[slot], ns / 1e6);
+  query_frame_[slot] = -1;
+  return true;
+}
+
+void Benchmark::Record(const std::string& series, long frame, double value) {
+  if (frame < options_.warmup || frame >= options_.warmup + options_.frames) {
+    return;
+  }
+  series_[series].push_back(value);
+}
+
+bool Benchmark::Finish() {
+  if (finished_) {
+    return true;
+  }
+  finished_ = true;
+  if (query_active_) {
+    // The frame was never presented; drop its query.
+    glEndQuery(GL_TIME_ELAPSED);
+    query_active_ = false;
+    query_frame_[frame_ % kQueryRing] = -1;
+  }
+  for (int slot = 0; slot < kQueryRing; ++slot) {
+    if (query_frame_[slot] >= 0) {
+      CollectQuery(slot, /*wait=*/true);
+    }
+  }
+  return WriteJson();
+}
+
+bool Benchmark::WriteJson() const {
+  std::ofstream out(options_.output);
+  if (!out) {
+    std::cout << "Could not write benchmark report to " << options_.output << std::endl;
+    return false;
+  }
+  out << "{\n"
+      << "  \"benchmark\": \"" << options_.name << "\",\n"
+      << "  \"warmup_frames\": " << options_.warmup << ",\n"
+      << "  \"frames\": " << std::max(0L, std::min(frame_, options_.warmup + options_.frames) -
+                                          options_.warmup) << ",\n"
+      << "  \"series\": {";
+  bool first = true;
+  for (const auto& series : series_) {
+    if (series.second.empty()) {
+      continue;
+    }
+    out << (first ? "\n" : ",\n");
+    write_series(out, series.first, series.second);
+    first = false;
+  }
+  out << "\n  }\n}\n";
+  std::cout << "Wrote benchmark report to " << options_.output << std::endl;
+  return true;
+}
+
+}
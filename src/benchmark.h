@@ -0,0 +1,74 @@
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <glad/glad.h>  // include glad to get all the required OpenGL headers
+
+#include "gl_resources.h"
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace experimentgl {
+
+struct BenchmarkOptions {
+  // Name of the benchmarked sample, as it appears in the report.
+  std::string name;
+  // Frames to measure. 0 disables benchmarking.
+  long frames = 0;
+  // Frames to render before measuring starts. Frame 0 also carries the
+  // sample's setup (shader compiles, texture decodes), so it is skipped
+  // unless --warmup=0 asks for it.
+  long warmup = 1;
+  // Where the JSON report is written.
+  std::string output = "benchmark.json";
+};
+
+// Measures a fixed number of frames and writes per-series percentiles and
+// histograms as JSON. Every frame records "frame_ms" (swap to swap),
+// "cpu_ms" (frame start to swap), "swap_ms" and "gpu_ms" (GL_TIME_ELAPSED
+// over the frame's commands); other modules can add their own series.
+class Benchmark {
+ public:
+  // Starts timing the first frame, so GL must already be loaded.
+  static std::unique_ptr<Benchmark> Create(const BenchmarkOptions& options);
+
+  // Bracket the buffer swap; EndSwap() also starts the next frame.
+  void BeginSwap();
+  void EndSwap();
+  // True once warmup + measured frames have been rendered.
+  bool Done() const { return frame_ >= options_.warmup + options_.frames; }
+  // Index of the frame being rendered, counting warmup frames.
+  long frame() const { return frame_; }
+  // Adds 'value' to 'series' on behalf of 'frame'. Warmup frames are dropped.
+  void Record(const std::string& series, long frame, double value);
+  // Collects outstanding GPU results and writes the report. Later calls do nothing.
+  bool Finish();
+
+ private:
+  // Number of frames a GPU query may stay in flight before we read it back.
+  static const int kQueryRing = 4;
+
+  explicit Benchmark(const BenchmarkOptions& options);
+  void BeginFrame();
+  // Records the GPU time of ring slot 'slot', waiting for it if 'wait' is set.
+  // Returns false if the result is not available yet.
+  bool CollectQuery(int slot, bool wait);
+  bool WriteJson() const;
+
+  BenchmarkOptions options_;
+  long frame_ = 0;
+  bool finished_ = false;
+  std::chrono::steady_clock::time_point frame_start_;
+  std::chrono::steady_clock::time_point swap_start_;
+  GlQuery queries_[kQueryRing];
+  // Frame each in-flight query belongs to, or -1 if the slot is free.
+  long query_frame_[kQueryRing];
+  bool query_active_ = false;
+  std::map<std::string, std::vector<double>> series_;
+};
+
+}
+#endif // BENCHMARK_H_
@@ -0,0 +1,403 @@
+#include "context.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLFW/glfw3.h>
+
+#include "gl_ext.h"
+#include "gl_intercept.h"
+#include "gl_resources.h"
+#include "gl_state.h"
+#include "program_cache.h"
+#include "shader_files.h"
+#include "shader_reloader.h"
+#include "trace.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace experimentgl {
+
+namespace {
+
+// Returns the value of "--name=value" if 'arg' is that flag, else nullptr.
+const char* flag_value(const char* arg, const char* name) {
+  size_t len = std::strlen(name);
+  if (std::strncmp(arg, name, len) != 0 || arg[len] != '=') {
+    return nullptr;
+  }
+  return arg + len + 1;
+}
+
+void* load_glfw_proc(const char* name) {
+  return reinterpret_cast<void*>(glfwGetProcAddress(name));
+}
+
+void* load_egl_proc(const char* name) {
+  return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+
+class GlfwContext : public Context {
+ public:
+  explicit GlfwContext(const ContextOptions& options) : Context(options) {}
+  ~GlfwContext() override {
+    ReleaseGl();
+    // glfw: terminate, clearing all previously allocated GLFW resources.
+    glfwTerminate();
+  }
+
+  bool IsKeyPressed(int key) const override { return glfwGetKey(window_, key) == GLFW_PRESS; }
+  double GetTime() const override { return glfwGetTime(); }
+  GLADloadproc proc_loader() const override { return load_glfw_proc; }
+
+ protected:
+  bool Init() override {
+    // glfw: initialize and configure
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, gl_major_);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, gl_minor_);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    window_ = glfwCreateWindow(width_, height_, title_.c_str(), NULL, NULL);
+    if (window_ == NULL) {
+      std::cout << "Failed to create GLFW window" << std::endl;
+      return false;
+    }
+    glfwMakeContextCurrent(window_);
+    glfwSetWindowUserPointer(window_, this);
+    glfwSetFramebufferSizeCallback(window_, framebuffer_size_callback);
+    return true;
+  }
+  bool WindowShouldClose() const override { return glfwWindowShouldClose(window_); }
+  void Present() override { glfwSwapBuffers(window_); }
+  void PollWindowEvents() override { glfwPollEvents(); }
+
+ private:
+  // glfw: whenever the window size changed (by OS or user resize) this callback function executes.
+  static void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+    GlfwContext* context = static_cast<GlfwContext*>(glfwGetWindowUserPointer(window));
+    context->width_ = width;
+    context->height_ = height;
+    // make sure the viewport matches the new window dimensions; note that width and
+    // height will be significantly larger than specified on retina displays.
+    GlState::Viewport(0, 0, width, height);
+  }
+
+  GLFWwindow* window_ = nullptr;
+};
+
+// Surfaceless EGL context (EGL_MESA_platform_surfaceless, or the default
+// display with EGL_KHR_surfaceless_context) rendering into an FBO of the
+// requested size. Works on llvmpipe with no display server.
+class HeadlessContext : public Context {
+ public:
+  explicit HeadlessContext(const ContextOptions& options)
+      : Context(options), start_(std::chrono::steady_clock::now()) {}
+  ~HeadlessContext() override {
+    ReleaseGl();
+    if (context_ != EGL_NO_CONTEXT) {
+      if (fbo_ != 0) {
+        glDeleteFramebuffers(1, &fbo_);
+        glDeleteRenderbuffers(2, renderbuffers_);
+      }
+      eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+      eglDestroyContext(display_, context_);
+    }
+    if (display_ != EGL_NO_DISPLAY) {
+      eglTerminate(display_);
+    }
+  }
+
+  bool IsKeyPressed(int) const override { return false; }
+  double GetTime() const override {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+  }
+  GLADloadproc proc_loader() const override { return load_egl_proc; }
+
+ protected:
+  bool Init() override {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (get_platform_display != nullptr) {
+      display_ = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if (display_ == EGL_NO_DISPLAY) {
+      display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    EGLint major, minor;
+    if (display_ == EGL_NO_DISPLAY || !eglInitialize(display_, &major, &minor)) {
+      std::cout << "Failed to initialize EGL display" << std::endl;
+      return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+      std::cout << "EGL does not support desktop OpenGL" << std::endl;
+      return false;
+    }
+    const EGLint config_attribs[] = {
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+      EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint num_configs = 0;
+    eglChooseConfig(display_, config_attribs, &config, 1, &num_configs);
+    const EGLint context_attribs[] = {
+      EGL_CONTEXT_MAJOR_VERSION, gl_major_,
+      EGL_CONTEXT_MINOR_VERSION, gl_minor_,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+      EGL_NONE
+    };
+    // EGL_KHR_no_config_context lets us go without a config when none match.
+    context_ = eglCreateContext(display_, num_configs > 0 ? config : EGL_NO_CONFIG_KHR,
+                                EGL_NO_CONTEXT, context_attribs);
+    if (context_ == EGL_NO_CONTEXT) {
+      std::cout << "Failed to create EGL context: 0x" << std::hex << eglGetError()
+                << std::dec << std::endl;
+      return false;
+    }
+    if (!eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, context_)) {
+      std::cout << "Failed to make surfaceless EGL context current" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  bool InitGl() override {
+    glGenRenderbuffers(2, renderbuffers_);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers_[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width_, height_);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers_[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width_, height_);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+                              renderbuffers_[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER,
+                              renderbuffers_[1]);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+      std::cout << "Offscreen framebuffer is incomplete" << std::endl;
+      return false;
+    }
+    // The FBO stays bound for the lifetime of the context, so samples draw
+    // into it exactly as they would into the default framebuffer.
+    GlState::Viewport(0, 0, width_, height_);
+    return true;
+  }
+  bool WindowShouldClose() const override { return false; }
+  // Nothing to show; just make sure the frame's commands are submitted.
+  void Present() override { glFlush(); }
+  void PollWindowEvents() override {}
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+  EGLDisplay display_ = EGL_NO_DISPLAY;
+  EGLContext context_ = EGL_NO_CONTEXT;
+  unsigned int fbo_ = 0;
+  // Color and depth-stencil attachments.
+  unsigned int renderbuffers_[2] = {0, 0};
+};
+
+} // anonymous namespace.
+
+ContextOptions ParseContextOptions(int argc, char** argv, ContextOptions options) {
+  for (int i = 1; i < argc; ++i) {
+    const char* value;
+    if (std::strcmp(argv[i], "--headless") == 0) {
+      options.backend = ContextBackend::kHeadless;
+    } else if (std::strcmp(argv[i], "--gpu-profile") == 0) {
+      options.gpu_profile = true;
+    } else if (std::strcmp(argv[i], "--gl-intercept") == 0) {
+      options.gl_intercept = true;
+    } else if (std::strcmp(argv[i], "--hot-reload") == 0) {
+      options.hot_reload = true;
+    } else if ((value = flag_value(argv[i], "--width")) != nullptr) {
+      options.width = std::atoi(value);
+    } else if ((value = flag_value(argv[i], "--height")) != nullptr) {
+      options.height = std::atoi(value);
+    } else if ((value = flag_value(argv[i], "--frames")) != nullptr) {
+      options.frames = std::atol(value);
+    } else if ((value = flag_value(argv[i], "--bench-frames")) != nullptr) {
+      options.benchmark.frames = std::atol(value);
+    } else if ((value = flag_value(argv[i], "--warmup")) != nullptr) {
+      options.benchmark.warmup = std::atol(value);
+    } else if ((value = flag_value(argv[i], "--bench-out")) != nullptr) {
+      options.benchmark.output = value;
+    } else if ((value = flag_value(argv[i], "--trace-out")) != nullptr) {
+      options.trace_output = value;
+    } else if ((value = flag_value(argv[i], "--shader-cache")) != nullptr) {
+      options.shader_cache = value;
+    } else if ((value = flag_value(argv[i], "--shader-dir")) != nullptr) {
+      options.shader_dir = value;
+    }
+  }
+  if (options.benchmark.name.empty() && argc > 0) {
+    const char* slash = std::strrchr(argv[0], '/');
+    options.benchmark.name = slash != nullptr ? slash + 1 : argv[0];
+  }
+  return options;
+}
+
+Context::Context(const ContextOptions& options)
+    : width_(options.width), height_(options.height), title_(options.title),
+      gl_major_(options.gl_major), gl_minor_(options.gl_minor),
+      frames_(options.frames), benchmark_options_(options.benchmark),
+      gpu_profile_(options.gpu_profile || options.benchmark.frames > 0),
+      trace_output_(options.trace_output), gl_intercept_(options.gl_intercept) {
+  if (benchmark_options_.frames > 0) {
+    frames_ = benchmark_options_.warmup + benchmark_options_.frames;
+  }
+}
+
+std::unique_ptr<Context> Context::Create(const ContextOptions& options) {
+  if (options.width <= 0 || options.height <= 0) {
+    std::cout << "Invalid context size " << options.width << "x" << options.height << std::endl;
+    return nullptr;
+  }
+  std::unique_ptr<Context> context;
+  switch (options.backend) {
+    case ContextBackend::kGlfw:
+      context.reset(new GlfwContext(options));
+      break;
+    case ContextBackend::kHeadless:
+      context.reset(new HeadlessContext(options));
+      break;
+  }
+  if (!context->Init()) {
+    return nullptr;
+  }
+  // glad: load all OpenGL function pointers
+  if (!gladLoadGLLoader(context->proc_loader())) {
+    std::cout << "Failed to initialize GLAD" << std::endl;
+    return nullptr;
+  }
+  LoadGlExt(context->proc_loader());
+  if (gl_ext().MaxShaderCompilerThreads != nullptr) {
+    // Let the driver compile on as many threads as it likes.
+    gl_ext().MaxShaderCompilerThreads(0xFFFFFFFF);
+  }
+  if (!options.shader_cache.empty()) {
+    ProgramCache::Enable(options.shader_cache);
+  }
+  if (!options.shader_dir.empty()) {
+    ShaderFiles::SetOverrideDir(options.shader_dir);
+  } else if (options.hot_reload) {
+    // Edits can only be picked up from disk.
+    ShaderFiles::SetOverrideDir(".");
+  }
+  if (options.hot_reload) {
+    ShaderReloader::Enable();
+  }
+  // Nothing is known about a fresh context's bindings.
+  GlState::Invalidate();
+  if (!context->InitGl()) {
+    return nullptr;
+  }
+  if (context->gl_intercept_) {
+    GlIntercept::Install();
+  }
+  if (context->benchmark_options_.frames > 0) {
+    context->benchmark_ = Benchmark::Create(context->benchmark_options_);
+    if (context->benchmark_ == nullptr) {
+      return nullptr;
+    }
+  }
+  if (context->gpu_profile_) {
+    context->gpu_profiler_ = GpuProfiler::Create();
+    if (context->gpu_profiler_ == nullptr) {
+      return nullptr;
+    }
+    context->gpu_profiler_->set_benchmark(context->benchmark_.get());
+    GpuProfiler::set_current(context->gpu_profiler_.get());
+    context->gpu_profiler_->BeginFrame(0);
+  }
+  if (!context->trace_output_.empty()) {
+    Trace::Enable();
+    context->frame_begin_us_ = Trace::Now();
+  }
+  return context;
+}
+
+bool Context::ShouldClose() {
+  if (frames_ > 0 && frame_ >= frames_) {
+    should_close_ = true;
+  }
+  bool close = should_close_ || WindowShouldClose();
+  // Report while the GL context is still alive to read back queries.
+  if (close && !reported_) {
+    reported_ = true;
+    if (gpu_profiler_ != nullptr) {
+      gpu_profiler_->Flush();
+      gpu_profiler_->PrintSummary();
+    }
+    if (gl_intercept_) {
+      GlIntercept::PrintSummary();
+    }
+    if (benchmark_ != nullptr) {
+      benchmark_->Finish();
+    }
+    if (!trace_output_.empty()) {
+      Trace::WriteJson(trace_output_);
+    }
+  }
+  return close;
+}
+
+void Context::SetShouldClose() {
+  should_close_ = true;
+}
+
+void Context::PollEvents() {
+  TRACE_SCOPE("PollEvents");
+  PollWindowEvents();
+}
+
+void Context::ReleaseGl() {
+  gpu_profiler_.reset();
+  benchmark_.reset();
+  // Samples declare their objects after the context, so anything left now
+  // was never released.
+  GlResources::ReportLeaks();
+}
+
+void Context::SwapBuffers() {
+  if (gpu_profiler_ != nullptr) {
+    gpu_profiler_->EndFrame();
+  }
+  if (benchmark_ != nullptr) {
+    benchmark_->BeginSwap();
+  }
+  {
+    TRACE_SCOPE("SwapBuffers");
+    Present();
+  }
+  if (gl_intercept_) {
+    // Before EndSwap(), which starts timing the next frame.
+    GlIntercept::EndFrame(benchmark_.get(), frame_);
+  }
+  GlResources::EndFrame(benchmark_.get(), frame_);
+  if (benchmark_ != nullptr) {
+    benchmark_->EndSwap();
+  }
+  if (Trace::enabled()) {
+    uint64_t now = Trace::Now();
+    Trace::Record("frame", frame_begin_us_, now);
+    frame_begin_us_ = now;
+  }
+  ++frame_;
+  if (ShaderReloader::enabled()) {
+    // Between frames, so a swapped program is used for all of the next one.
+    TRACE_SCOPE("shader reload");
+    ShaderReloader::Poll();
+  }
+  if (gpu_profiler_ != nullptr) {
+    gpu_profiler_->BeginFrame(frame_);
+  }
+}
+
+}
@@ -0,0 +1,131 @@
+#ifndef CONTEXT_H_
+#define CONTEXT_H_
+
+#include <glad/glad.h>  // include glad to get all the required OpenGL headers
+
+#include "benchmark.h"
+#include "gpu_profiler.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace experimentgl {
+
+// Which windowing system provides the GL context.
+enum class ContextBackend {
+  // On-screen GLFW window.
+  kGlfw,
+  // EGL surfaceless context rendering into an offscreen FBO. Needs no X server.
+  kHeadless,
+};
+
+struct ContextOptions {
+  ContextBackend backend = ContextBackend::kGlfw;
+  // Window size, or FBO size for the headless backend.
+  int width = 800;
+  int height = 600;
+  std::string title = "Experiments";
+  // Lowest core profile version to create. Drivers may hand out a newer one.
+  int gl_major = 3;
+  int gl_minor = 3;
+  // Number of frames to render before ShouldClose() returns true. 0 means run
+  // until the window is closed.
+  long frames = 0;
+  // Enabled when benchmark.frames > 0; the frame budget then becomes
+  // warmup + benchmark frames.
+  BenchmarkOptions benchmark;
+  // Installs a GpuProfiler so GpuScope timings are collected and printed on
+  // exit. Always on while benchmarking, which reports them as series.
+  bool gpu_profile = false;
+  // If set, CPU trace events are recorded and written here as
+  // chrome://tracing JSON when the context closes.
+  std::string trace_output;
+  // Counts GL calls and redundant binds per frame (see GlIntercept). The
+  // counts go into the benchmark report and are printed on exit.
+  bool gl_intercept = false;
+  // Directory linked program binaries are cached in (see ProgramCache).
+  // Empty disables the cache.
+  std::string shader_cache = ".shader_cache";
+  // Directory whose shader files take precedence over the copies embedded
+  // at build time (see ShaderFiles). Empty reads nothing from disk.
+  std::string shader_dir;
+  // Rebuilds shaders whose files change while running (see ShaderReloader).
+  // Without shader_dir, files are then read from the working directory.
+  bool hot_reload = false;
+};
+
+// Overrides 'options' with any of --headless, --width=W, --height=H,
+// --frames=N, --bench-frames=N, --warmup=M, --bench-out=PATH,
+// --gpu-profile, --trace-out=PATH, --gl-intercept, --shader-cache=DIR,
+// --shader-dir=DIR and --hot-reload found in argv. Unknown arguments are left for other parsers.
+ContextOptions ParseContextOptions(int argc, char** argv, ContextOptions options);
+
+// Owns the GL context a sample renders with, and hides whether it is backed by
+// a window or by an offscreen framebuffer.
+class Context {
+ public:
+  // Creates the context, makes it current and loads GL through glad. Returns
+  // nullptr if any of that fails.
+  static std::unique_ptr<Context> Create(const ContextOptions& options);
+  virtual ~Context() = default;
+
+  // True once the user closed the window or the frame budget ran out.
+  bool ShouldClose();
+  void SetShouldClose();
+  // Presents the frame and advances the frame counter.
+  void SwapBuffers();
+  void PollEvents();
+  // 'key' is a GLFW key code. Always false without a window.
+  virtual bool IsKeyPressed(int key) const = 0;
+  // Seconds since the context was created.
+  virtual double GetTime() const = 0;
+  // Resolves GL entry points for the current context; usable with glad.
+  virtual GLADloadproc proc_loader() const = 0;
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  // Number of frames presented so far.
+  long frame() const { return frame_; }
+  // nullptr unless the context was created with benchmarking enabled.
+  Benchmark* benchmark() const { return benchmark_.get(); }
+  // nullptr unless GPU profiling is enabled.
+  GpuProfiler* gpu_profiler() const { return gpu_profiler_.get(); }
+
+ protected:
+  explicit Context(const ContextOptions& options);
+  // returns 'false' if the context could not be created.
+  virtual bool Init() = 0;
+  // Called once the GL entry points are loaded.
+  virtual bool InitGl() { return true; }
+  virtual bool WindowShouldClose() const = 0;
+  virtual void Present() = 0;
+  virtual void PollWindowEvents() = 0;
+  // Destroys GL objects owned by this class. Backends call it before tearing
+  // the GL context down.
+  void ReleaseGl();
+
+  int width_;
+  int height_;
+  std::string title_;
+  int gl_major_;
+  int gl_minor_;
+
+ private:
+  long frames_;
+  long frame_ = 0;
+  bool should_close_ = false;
+  // Set once results have been reported at shutdown.
+  bool reported_ = false;
+  BenchmarkOptions benchmark_options_;
+  std::unique_ptr<Benchmark> benchmark_;
+  bool gpu_profile_;
+  std::unique_ptr<GpuProfiler> gpu_profiler_;
+  std::string trace_output_;
+  bool gl_intercept_;
+  // Trace clock time the current frame started at.
+  uint64_t frame_begin_us_ = 0;
+};
+
+}
+#endif // CONTEXT_H_
@@ -0,0 +1,105 @@
+// Build tool: writes a C++ source file embedding shader files, so samples
+// do not read them at startup (see shader_files.h).
+//
+//   embed_glsl OUTPUT.cpp FILE...
+//
+// Each FILE is stored under the path it was given as, and the table is
+// sorted by that path.
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 'contents' as C string literals, one per source line.
+std::string escape(const std::string& contents) {
+  std::string literal = "\"";
+  for (size_t i = 0; i < contents.size(); ++i) {
+    unsigned char c = contents[i];
+    if (c == '\n') {
+      literal += "\\n\"";
+      if (i + 1 < contents.size()) {
+        literal += "\n    \"";
+      }
+      continue;
+    }
+    if (c == '"' || c == '\\') {
+      literal += '\\';
+      literal += c;
+    } else if (c == '?') {
+      // Keeps "??" sequences from reading as trigraphs.
+      literal += "\\?";
+    } else if (c < 0x20 || c >= 0x7f) {
+      char octal[5];
+      std::snprintf(octal, sizeof(octal), "\\%03o", c);
+      literal += octal;
+    } else {
+      literal += c;
+    }
+  }
+  if (contents.empty() || contents.back() != '\n') {
+    literal += '"';
+  }
+  return literal;
+}
+
+} // anonymous namespace.
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cout << "usage: embed_glsl OUTPUT.cpp FILE..." << std::endl;
+    return 1;
+  }
+  std::vector<std::string> paths(argv + 2, argv + argc);
+  std::sort(paths.begin(), paths.end());
+  paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+
+  std::ostringstream out;
+  out << "// Generated by embed_glsl. Do not edit.\n\n"
+      << "#include \"shader_files.h\"\n\n"
+      << "namespace experimentgl {\n\n"
+      << "namespace {\n\n";
+  for (size_t i = 0; i < paths.size(); ++i) {
+    std::ifstream file(paths[i], std::ios::binary);
+    if (!file) {
+      std::cout << "embed_glsl: cannot read " << paths[i] << std::endl;
+      return 1;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    out << "// " << paths[i] << "\n"
+        << "constexpr char kFile" << i << "[] =\n    " << escape(contents.str()) << ";\n\n";
+  }
+  out << "} // anonymous namespace.\n\n"
+      << "// Sorted by path.\n"
+      << "extern constexpr EmbeddedFile kEmbeddedFiles[] = {\n";
+  for (size_t i = 0; i < paths.size(); ++i) {
+    out << "  {\"" << paths[i] << "\", kFile" << i << ", sizeof(kFile" << i << ") - 1},\n";
+  }
+  if (paths.empty()) {
+    out << "  {\"\", \"\", 0},\n";
+  }
+  out << "};\n"
+      << "extern const size_t kNumEmbeddedFiles = " << paths.size() << ";\n\n"
+      << "}\n";
+
+  // Only touch the output when it changes, so dependents are not rebuilt.
+  std::ifstream previous(argv[1], std::ios::binary);
+  std::ostringstream previous_contents;
+  previous_contents << previous.rdbuf();
+  if (previous && previous_contents.str() == out.str()) {
+    return 0;
+  }
+  std::ofstream output(argv[1], std::ios::binary | std::ios::trunc);
+  output << out.str();
+  if (!output) {
+    std::cout << "embed_glsl: cannot write " << argv[1] << std::endl;
+    return 1;
+  }
+  return 0;
+}
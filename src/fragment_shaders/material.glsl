@@ -0,0 +1,8 @@
+// Material parameters shared by every program that includes this file.
+// Mirrors struct Material on the C++ side, member for member.
+layout(std140) uniform Material {
+  vec4 tint;
+  vec2 uv_scale;
+  vec2 uv_offset;
+  float brightness;
+};
@@ -0,0 +1,13 @@
+#version 330 core
+
+// Output variable FragColor.
+out vec4 FragColor;
+
+// Injected per variant, e.g. COLOR=vec4(1.0f, 0.5f, 0.2f, 1.0f).
+#ifndef COLOR
+#define COLOR vec4(1.0f, 1.0f, 1.0f, 1.0f)
+#endif
+
+void main() {
+  FragColor = COLOR;
+}
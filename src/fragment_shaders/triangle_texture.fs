@@ -1,4 +1,5 @@
 #version 330 core
+#include "material.glsl"
 
 out vec4 FragColor;
 
@@ -9,5 +10,6 @@ in vec2 texCoord;
 uniform sampler2D ourTexture;
 
 void main() {
-  FragColor = texture(ourTexture, texCoord);
+  vec4 texel = texture(ourTexture, texCoord * uv_scale + uv_offset);
+  FragColor = vec4(texel.rgb * tint.rgb * brightness, texel.a * tint.a);
 }
@@ -0,0 +1,11 @@
+#version 330 core
+
+// Output variable FragColor.
+out vec4 FragColor;
+
+// Set from the application every frame.
+uniform vec4 ourColor;
+
+void main() {
+  FragColor = ourColor;
+}
@@ -0,0 +1,66 @@
+#include "gl_ext.h"
+
+#include <cstring>
+
+namespace experimentgl {
+
+namespace {
+
+GlExt ext;
+
+// Stores the address of 'name' in 'fn', or nullptr if 'available' is false.
+template <typename Fn>
+void load_proc(GLADloadproc load, bool available, const char* name, Fn*& fn) {
+  fn = available ? reinterpret_cast<Fn*>(load(name)) : nullptr;
+}
+
+} // anonymous namespace.
+
+void LoadGlExt(GLADloadproc load) {
+  ext = GlExt();
+  bool program_binary = HasGlVersion(4, 1) || HasGlExtension("GL_ARB_get_program_binary");
+  load_proc(load, program_binary, "glGetProgramBinary", ext.GetProgramBinary);
+  load_proc(load, program_binary, "glProgramBinary", ext.ProgramBinary);
+  load_proc(load, program_binary, "glProgramParameteri", ext.ProgramParameteri);
+  bool separate_shader_objects =
+      HasGlVersion(4, 1) || HasGlExtension("GL_ARB_separate_shader_objects");
+  load_proc(load, separate_shader_objects, "glCreateShaderProgramv", ext.CreateShaderProgramv);
+  load_proc(load, separate_shader_objects, "glGenProgramPipelines", ext.GenProgramPipelines);
+  load_proc(load, separate_shader_objects, "glDeleteProgramPipelines", ext.DeleteProgramPipelines);
+  load_proc(load, separate_shader_objects, "glBindProgramPipeline", ext.BindProgramPipeline);
+  load_proc(load, separate_shader_objects, "glUseProgramStages", ext.UseProgramStages);
+  load_proc(load, HasGlVersion(4, 4) || HasGlExtension("GL_ARB_buffer_storage"),
+            "glBufferStorage", ext.BufferStorage);
+  if (HasGlExtension("GL_KHR_parallel_shader_compile")) {
+    load_proc(load, true, "glMaxShaderCompilerThreadsKHR", ext.MaxShaderCompilerThreads);
+  } else {
+    load_proc(load, HasGlExtension("GL_ARB_parallel_shader_compile"),
+              "glMaxShaderCompilerThreadsARB", ext.MaxShaderCompilerThreads);
+  }
+}
+
+const GlExt& gl_ext() {
+  return ext;
+}
+
+GlExt& mutable_gl_ext() {
+  return ext;
+}
+
+bool HasGlVersion(int major, int minor) {
+  return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+bool HasGlExtension(const char* name) {
+  GLint count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+  for (GLint i = 0; i < count; ++i) {
+    const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+    if (extension != nullptr && std::strcmp(extension, name) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}
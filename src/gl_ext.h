@@ -0,0 +1,69 @@
+#ifndef GL_EXT_H_
+#define GL_EXT_H_
+
+#include <glad/glad.h>  // include glad to get all the required OpenGL headers
+
+// Tokens missing from the GL 4.0 glad headers.
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
+#endif
+#ifndef GL_PROGRAM_SEPARABLE
+#define GL_VERTEX_SHADER_BIT 0x00000001
+#define GL_FRAGMENT_SHADER_BIT 0x00000002
+#define GL_PROGRAM_SEPARABLE 0x8258
+#define GL_PROGRAM_PIPELINE_BINDING 0x825A
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace experimentgl {
+
+// Entry points newer than the GL 4.0 core profile glad was generated for.
+// Each one is nullptr unless the context version or an extension provides it,
+// so callers test the pointer before using the feature.
+struct GlExt {
+  // GL 4.1 / ARB_get_program_binary.
+  void (APIENTRY* GetProgramBinary)(GLuint program, GLsizei buf_size, GLsizei* length,
+                                    GLenum* binary_format, void* binary) = nullptr;
+  void (APIENTRY* ProgramBinary)(GLuint program, GLenum binary_format, const void* binary,
+                                 GLsizei length) = nullptr;
+  void (APIENTRY* ProgramParameteri)(GLuint program, GLenum pname, GLint value) = nullptr;
+  // KHR_parallel_shader_compile, or its ARB twin. When set, compile and link
+  // status can be polled with GL_COMPLETION_STATUS_KHR without blocking.
+  void (APIENTRY* MaxShaderCompilerThreads)(GLuint count) = nullptr;
+  // GL 4.1 / ARB_separate_shader_objects.
+  GLuint (APIENTRY* CreateShaderProgramv)(GLenum type, GLsizei count,
+                                          const GLchar* const* strings) = nullptr;
+  void (APIENTRY* GenProgramPipelines)(GLsizei n, GLuint* pipelines) = nullptr;
+  void (APIENTRY* DeleteProgramPipelines)(GLsizei n, const GLuint* pipelines) = nullptr;
+  void (APIENTRY* BindProgramPipeline)(GLuint pipeline) = nullptr;
+  void (APIENTRY* UseProgramStages)(GLuint pipeline, GLbitfield stages, GLuint program) = nullptr;
+  // GL 4.4 / ARB_buffer_storage: immutable storage that can stay mapped.
+  void (APIENTRY* BufferStorage)(GLenum target, GLsizeiptr size, const void* data,
+                                 GLbitfield flags) = nullptr;
+};
+
+// Loads the entry points above through 'load'. Call once, after glad.
+void LoadGlExt(GLADloadproc load);
+// The entry points of the current context.
+const GlExt& gl_ext();
+// The same table, for GlIntercept to swap in its counting wrappers.
+GlExt& mutable_gl_ext();
+// True if the context is at least GL major.minor.
+bool HasGlVersion(int major, int minor);
+// True if the context advertises extension 'name', e.g. "GL_ARB_get_program_binary".
+bool HasGlExtension(const char* name);
+
+}
+#endif // GL_EXT_H_
@@ -0,0 +1,520 @@
+#include "gl_intercept.h"
+
+#include "benchmark.h"
+#include "gl_ext.h"
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace experimentgl {
+
+namespace {
+
+enum Kind { kDraw, kBind, kState, kUniform, kResource, kOther };
+
+// glUniform*v and glUniformMatrix*fv, which differ only in name and type.
+#define GL_UNIFORM_VECTOR(X, name, type) \
+  X(kUniform, void, name, (GLint location, GLsizei count, const type* value), \
+    (location, count, value))
+#define GL_UNIFORM_MATRIX(X, name) \
+  X(kUniform, void, name, \
+    (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), \
+    (location, count, transpose, value))
+
+// glad entry points forwarded by a generated wrapper that only counts:
+// X(kind, return type, name without "gl", parameters, arguments). Every glad
+// entry point the sources call is listed, so per-frame totals are complete.
+#define GL_COUNTED_CALLS(X) \
+  X(kDraw, void, DrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count)) \
+  X(kDraw, void, DrawElements, (GLenum mode, GLsizei count, GLenum type, const void* indices), \
+    (mode, count, type, indices)) \
+  X(kDraw, void, DrawArraysInstanced, \
+    (GLenum mode, GLint first, GLsizei count, GLsizei instancecount), \
+    (mode, first, count, instancecount)) \
+  X(kDraw, void, DrawElementsInstanced, \
+    (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount), \
+    (mode, count, type, indices, instancecount)) \
+  X(kDraw, void, DrawElementsBaseVertex, \
+    (GLenum mode, GLsizei count, GLenum type, const void* indices, GLint basevertex), \
+    (mode, count, type, indices, basevertex)) \
+  X(kDraw, void, DrawRangeElements, \
+    (GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const void* indices), \
+    (mode, start, end, count, type, indices)) \
+  X(kBind, void, BindBufferBase, (GLenum target, GLuint index, GLuint buffer), \
+    (target, index, buffer)) \
+  X(kBind, void, BindBufferRange, \
+    (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size), \
+    (target, index, buffer, offset, size)) \
+  X(kBind, void, BindRenderbuffer, (GLenum target, GLuint renderbuffer), (target, renderbuffer)) \
+  X(kBind, void, BindSampler, (GLuint unit, GLuint sampler), (unit, sampler)) \
+  X(kState, void, Enable, (GLenum cap), (cap)) \
+  X(kState, void, Disable, (GLenum cap), (cap)) \
+  X(kState, void, Viewport, (GLint x, GLint y, GLsizei width, GLsizei height), \
+    (x, y, width, height)) \
+  X(kState, void, Scissor, (GLint x, GLint y, GLsizei width, GLsizei height), \
+    (x, y, width, height)) \
+  X(kState, void, BlendFunc, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor)) \
+  X(kState, void, DepthFunc, (GLenum func), (func)) \
+  X(kState, void, DepthMask, (GLboolean flag), (flag)) \
+  X(kState, void, CullFace, (GLenum mode), (mode)) \
+  X(kState, void, PolygonMode, (GLenum face, GLenum mode), (face, mode)) \
+  X(kState, void, ClearColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), \
+    (red, green, blue, alpha)) \
+  X(kState, void, PixelStorei, (GLenum pname, GLint param), (pname, param)) \
+  X(kState, void, TexParameteri, (GLenum target, GLenum pname, GLint param), \
+    (target, pname, param)) \
+  X(kUniform, void, Uniform1i, (GLint location, GLint v0), (location, v0)) \
+  X(kUniform, void, Uniform1f, (GLint location, GLfloat v0), (location, v0)) \
+  X(kUniform, void, Uniform2f, (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1)) \
+  X(kUniform, void, Uniform3f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2), \
+    (location, v0, v1, v2)) \
+  X(kUniform, void, Uniform4f, \
+    (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), \
+    (location, v0, v1, v2, v3)) \
+  GL_UNIFORM_VECTOR(X, Uniform1iv, GLint) \
+  GL_UNIFORM_VECTOR(X, Uniform2iv, GLint) \
+  GL_UNIFORM_VECTOR(X, Uniform3iv, GLint) \
+  GL_UNIFORM_VECTOR(X, Uniform4iv, GLint) \
+  GL_UNIFORM_VECTOR(X, Uniform1uiv, GLuint) \
+  GL_UNIFORM_VECTOR(X, Uniform2uiv, GLuint) \
+  GL_UNIFORM_VECTOR(X, Uniform3uiv, GLuint) \
+  GL_UNIFORM_VECTOR(X, Uniform4uiv, GLuint) \
+  GL_UNIFORM_VECTOR(X, Uniform1fv, GLfloat) \
+  GL_UNIFORM_VECTOR(X, Uniform2fv, GLfloat) \
+  GL_UNIFORM_VECTOR(X, Uniform3fv, GLfloat) \
+  GL_UNIFORM_VECTOR(X, Uniform4fv, GLfloat) \
+  GL_UNIFORM_MATRIX(X, UniformMatrix2fv) \
+  GL_UNIFORM_MATRIX(X, UniformMatrix3fv) \
+  GL_UNIFORM_MATRIX(X, UniformMatrix4fv) \
+  GL_UNIFORM_MATRIX(X, UniformMatrix2x3fv) \
+  GL_UNIFORM_MATRIX(X, UniformMatrix2x4fv) \
+  GL_UNIFORM_MATRIX(X, UniformMatrix3x2fv) \
+  GL_UNIFORM_MATRIX(X, UniformMatrix3x4fv) \
+  GL_UNIFORM_MATRIX(X, UniformMatrix4x2fv) \
+  GL_UNIFORM_MATRIX(X, UniformMatrix4x3fv) \
+  X(kUniform, void, UniformBlockBinding, (GLuint program, GLuint index, GLuint binding), \
+    (program, index, binding)) \
+  X(kOther, GLint, GetUniformLocation, (GLuint program, const GLchar* name), (program, name)) \
+  X(kResource, void, GenBuffers, (GLsizei n, GLuint* buffers), (n, buffers)) \
+  X(kResource, void, BufferData, \
+    (GLenum target, GLsizeiptr size, const void* data, GLenum usage), \
+    (target, size, data, usage)) \
+  X(kResource, void, BufferSubData, \
+    (GLenum target, GLintptr offset, GLsizeiptr size, const void* data), \
+    (target, offset, size, data)) \
+  X(kResource, void*, MapBufferRange, \
+    (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access), \
+    (target, offset, length, access)) \
+  X(kResource, GLboolean, UnmapBuffer, (GLenum target), (target)) \
+  X(kResource, void, GenVertexArrays, (GLsizei n, GLuint* arrays), (n, arrays)) \
+  X(kState, void, VertexAttribPointer, \
+    (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, \
+     const void* pointer), \
+    (index, size, type, normalized, stride, pointer)) \
+  X(kState, void, VertexAttribIPointer, \
+    (GLuint index, GLint size, GLenum type, GLsizei stride, const void* pointer), \
+    (index, size, type, stride, pointer)) \
+  X(kState, void, EnableVertexAttribArray, (GLuint index), (index)) \
+  X(kResource, void, GenTextures, (GLsizei n, GLuint* textures), (n, textures)) \
+  X(kResource, void, TexImage2D, \
+    (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, \
+     GLint border, GLenum format, GLenum type, const void* pixels), \
+    (target, level, internalformat, width, height, border, format, type, pixels)) \
+  X(kResource, void, GenerateMipmap, (GLenum target), (target)) \
+  X(kResource, void, GenFramebuffers, (GLsizei n, GLuint* framebuffers), (n, framebuffers)) \
+  X(kResource, void, DeleteFramebuffers, (GLsizei n, const GLuint* framebuffers), \
+    (n, framebuffers)) \
+  X(kResource, void, GenRenderbuffers, (GLsizei n, GLuint* renderbuffers), (n, renderbuffers)) \
+  X(kResource, void, DeleteRenderbuffers, (GLsizei n, const GLuint* renderbuffers), \
+    (n, renderbuffers)) \
+  X(kResource, void, RenderbufferStorage, \
+    (GLenum target, GLenum internalformat, GLsizei width, GLsizei height), \
+    (target, internalformat, width, height)) \
+  X(kResource, void, FramebufferRenderbuffer, \
+    (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer), \
+    (target, attachment, renderbuffertarget, renderbuffer)) \
+  X(kOther, GLenum, CheckFramebufferStatus, (GLenum target), (target)) \
+  X(kResource, void, GenQueries, (GLsizei n, GLuint* ids), (n, ids)) \
+  X(kResource, void, DeleteQueries, (GLsizei n, const GLuint* ids), (n, ids)) \
+  X(kOther, void, BeginQuery, (GLenum target, GLuint id), (target, id)) \
+  X(kOther, void, EndQuery, (GLenum target), (target)) \
+  X(kOther, void, QueryCounter, (GLuint id, GLenum target), (id, target)) \
+  X(kOther, void, GetQueryObjectiv, (GLuint id, GLenum pname, GLint* params), \
+    (id, pname, params)) \
+  X(kOther, void, GetQueryObjectui64v, (GLuint id, GLenum pname, GLuint64* params), \
+    (id, pname, params)) \
+  X(kOther, GLsync, FenceSync, (GLenum condition, GLbitfield flags), (condition, flags)) \
+  X(kOther, GLenum, ClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout), \
+    (sync, flags, timeout)) \
+  X(kOther, void, DeleteSync, (GLsync sync), (sync)) \
+  X(kResource, GLuint, CreateShader, (GLenum type), (type)) \
+  X(kResource, void, ShaderSource, \
+    (GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length), \
+    (shader, count, string, length)) \
+  X(kResource, void, CompileShader, (GLuint shader), (shader)) \
+  X(kResource, void, DeleteShader, (GLuint shader), (shader)) \
+  X(kResource, GLuint, CreateProgram, (void), ()) \
+  X(kResource, void, AttachShader, (GLuint program, GLuint shader), (program, shader)) \
+  X(kResource, void, LinkProgram, (GLuint program), (program)) \
+  X(kOther, void, GetShaderiv, (GLuint shader, GLenum pname, GLint* params), \
+    (shader, pname, params)) \
+  X(kOther, void, GetProgramiv, (GLuint program, GLenum pname, GLint* params), \
+    (program, pname, params)) \
+  X(kOther, void, GetShaderInfoLog, \
+    (GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog), \
+    (shader, bufSize, length, infoLog)) \
+  X(kOther, void, GetProgramInfoLog, \
+    (GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog), \
+    (program, bufSize, length, infoLog)) \
+  X(kOther, GLint, GetAttribLocation, (GLuint program, const GLchar* name), (program, name)) \
+  X(kOther, void, GetActiveAttrib, \
+    (GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, \
+     GLenum* type, GLchar* name), \
+    (program, index, bufSize, length, size, type, name)) \
+  X(kOther, void, GetActiveUniformName, \
+    (GLuint program, GLuint uniformIndex, GLsizei bufSize, GLsizei* length, \
+     GLchar* uniformName), \
+    (program, uniformIndex, bufSize, length, uniformName)) \
+  X(kOther, void, GetActiveUniformsiv, \
+    (GLuint program, GLsizei uniformCount, const GLuint* uniformIndices, GLenum pname, \
+     GLint* params), \
+    (program, uniformCount, uniformIndices, pname, params)) \
+  X(kOther, void, GetActiveUniformBlockName, \
+    (GLuint program, GLuint uniformBlockIndex, GLsizei bufSize, GLsizei* length, \
+     GLchar* uniformBlockName), \
+    (program, uniformBlockIndex, bufSize, length, uniformBlockName)) \
+  X(kOther, void, GetActiveUniformBlockiv, \
+    (GLuint program, GLuint uniformBlockIndex, GLenum pname, GLint* params), \
+    (program, uniformBlockIndex, pname, params)) \
+  X(kOther, void, Clear, (GLbitfield mask), (mask)) \
+  X(kOther, void, Flush, (void), ()) \
+  X(kOther, void, Finish, (void), ()) \
+  X(kOther, GLenum, GetError, (void), ()) \
+  X(kOther, void, GetIntegerv, (GLenum pname, GLint* data), (pname, data)) \
+  X(kOther, const GLubyte*, GetString, (GLenum name), (name)) \
+  X(kOther, const GLubyte*, GetStringi, (GLenum name, GLuint index), (name, index))
+
+// GlExt entry points, wrapped the same way when the context provides them.
+#define GL_EXT_COUNTED_CALLS(X) \
+  X(kResource, void, GetProgramBinary, \
+    (GLuint program, GLsizei buf_size, GLsizei* length, GLenum* binary_format, void* binary), \
+    (program, buf_size, length, binary_format, binary)) \
+  X(kResource, void, ProgramBinary, \
+    (GLuint program, GLenum binary_format, const void* binary, GLsizei length), \
+    (program, binary_format, binary, length)) \
+  X(kResource, void, ProgramParameteri, (GLuint program, GLenum pname, GLint value), \
+    (program, pname, value)) \
+  X(kOther, void, MaxShaderCompilerThreads, (GLuint count), (count)) \
+  X(kResource, GLuint, CreateShaderProgramv, \
+    (GLenum type, GLsizei count, const GLchar* const* strings), (type, count, strings)) \
+  X(kResource, void, GenProgramPipelines, (GLsizei n, GLuint* pipelines), (n, pipelines)) \
+  X(kResource, void, DeleteProgramPipelines, (GLsizei n, const GLuint* pipelines), \
+    (n, pipelines)) \
+  X(kState, void, UseProgramStages, (GLuint pipeline, GLbitfield stages, GLuint program), \
+    (pipeline, stages, program)) \
+  X(kResource, void, BufferStorage, \
+    (GLenum target, GLsizeiptr size, const void* data, GLbitfield flags), \
+    (target, size, data, flags))
+
+// Entry points with hand-written wrappers below that also track bindings:
+// X(kind, name without "gl").
+#define GL_TRACKED_CALLS(X) \
+  X(kBind, UseProgram) \
+  X(kBind, BindVertexArray) \
+  X(kBind, BindBuffer) \
+  X(kBind, BindTexture) \
+  X(kBind, ActiveTexture) \
+  X(kBind, BindFramebuffer) \
+  X(kResource, DeleteProgram) \
+  X(kResource, DeleteBuffers) \
+  X(kResource, DeleteVertexArrays) \
+  X(kResource, DeleteTextures)
+#define GL_EXT_TRACKED_CALLS(X) \
+  X(kBind, BindProgramPipeline)
+
+#define ENTRY_ID(kind, ret, name, params, args) k##name,
+#define TRACKED_ENTRY_ID(kind, name) k##name,
+enum Entry {
+  GL_COUNTED_CALLS(ENTRY_ID) GL_TRACKED_CALLS(TRACKED_ENTRY_ID)
+  GL_EXT_COUNTED_CALLS(ENTRY_ID) GL_EXT_TRACKED_CALLS(TRACKED_ENTRY_ID)
+  kNumEntries
+};
+
+#define ENTRY_INFO(kind, ret, name, params, args) {"gl" #name, kind},
+#define TRACKED_ENTRY_INFO(kind, name) {"gl" #name, kind},
+const struct {
+  const char* name;
+  Kind kind;
+} kEntries[] = {
+  GL_COUNTED_CALLS(ENTRY_INFO) GL_TRACKED_CALLS(TRACKED_ENTRY_INFO)
+  GL_EXT_COUNTED_CALLS(ENTRY_INFO) GL_EXT_TRACKED_CALLS(TRACKED_ENTRY_INFO)
+};
+
+// Texture units shadowed for redundant-bind detection.
+const int kMaxTextureUnits = 32;
+
+bool is_installed = false;
+long frame_counts[kNumEntries];
+long frame_redundant = 0;
+GlFrameCounters last_counters;
+// Totals over all closed frames, for PrintSummary().
+long total_counts[kNumEntries];
+long total_redundant = 0;
+long total_frames = 0;
+
+// Shadow of the bindings the tracked wrappers have seen.
+struct Bindings {
+  GLuint program = 0;
+  GLuint program_pipeline = 0;
+  GLuint vertex_array = 0;
+  GLuint array_buffer = 0;
+  // GL_ELEMENT_ARRAY_BUFFER is part of VAO state, so it is kept per VAO.
+  std::map<GLuint, GLuint> element_buffer;
+  GLenum active_texture = GL_TEXTURE0;
+  // GL_TEXTURE_2D only; other targets are counted but not shadowed.
+  GLuint texture_2d[kMaxTextureUnits] = {};
+  GLuint draw_framebuffer = 0;
+  GLuint read_framebuffer = 0;
+} bindings;
+
+void count_call(Entry entry) {
+  ++frame_counts[entry];
+}
+
+// Counts a bind and returns whether it changed anything.
+bool track(GLuint& shadow, GLuint value) {
+  if (shadow == value) {
+    ++frame_redundant;
+    return false;
+  }
+  shadow = value;
+  return true;
+}
+
+#define REAL_POINTER(kind, ret, name, params, args) decltype(glad_gl##name) real_gl##name;
+#define TRACKED_REAL_POINTER(kind, name) decltype(glad_gl##name) real_gl##name;
+GL_COUNTED_CALLS(REAL_POINTER)
+GL_TRACKED_CALLS(TRACKED_REAL_POINTER)
+#define EXT_REAL_POINTER(kind, ret, name, params, args) decltype(GlExt::name) real_gl##name;
+#define EXT_TRACKED_REAL_POINTER(kind, name) decltype(GlExt::name) real_gl##name;
+GL_EXT_COUNTED_CALLS(EXT_REAL_POINTER)
+GL_EXT_TRACKED_CALLS(EXT_TRACKED_REAL_POINTER)
+
+#define COUNTING_WRAPPER(kind, ret, name, params, args) \
+  ret APIENTRY wrap_gl##name params { \
+    count_call(k##name); \
+    return real_gl##name args; \
+  }
+GL_COUNTED_CALLS(COUNTING_WRAPPER)
+GL_EXT_COUNTED_CALLS(COUNTING_WRAPPER)
+
+void APIENTRY wrap_glUseProgram(GLuint program) {
+  count_call(kUseProgram);
+  track(bindings.program, program);
+  real_glUseProgram(program);
+}
+
+void APIENTRY wrap_glBindProgramPipeline(GLuint pipeline) {
+  count_call(kBindProgramPipeline);
+  track(bindings.program_pipeline, pipeline);
+  real_glBindProgramPipeline(pipeline);
+}
+
+void APIENTRY wrap_glBindVertexArray(GLuint array) {
+  count_call(kBindVertexArray);
+  track(bindings.vertex_array, array);
+  real_glBindVertexArray(array);
+}
+
+void APIENTRY wrap_glBindBuffer(GLenum target, GLuint buffer) {
+  count_call(kBindBuffer);
+  if (target == GL_ARRAY_BUFFER) {
+    track(bindings.array_buffer, buffer);
+  } else if (target == GL_ELEMENT_ARRAY_BUFFER) {
+    track(bindings.element_buffer[bindings.vertex_array], buffer);
+  }
+  real_glBindBuffer(target, buffer);
+}
+
+void APIENTRY wrap_glActiveTexture(GLenum texture) {
+  count_call(kActiveTexture);
+  track(bindings.active_texture, texture);
+  real_glActiveTexture(texture);
+}
+
+void APIENTRY wrap_glBindTexture(GLenum target, GLuint texture) {
+  count_call(kBindTexture);
+  int unit = bindings.active_texture - GL_TEXTURE0;
+  if (target == GL_TEXTURE_2D && unit >= 0 && unit < kMaxTextureUnits) {
+    track(bindings.texture_2d[unit], texture);
+  }
+  real_glBindTexture(target, texture);
+}
+
+void APIENTRY wrap_glBindFramebuffer(GLenum target, GLuint framebuffer) {
+  count_call(kBindFramebuffer);
+  if (target == GL_READ_FRAMEBUFFER) {
+    track(bindings.read_framebuffer, framebuffer);
+  } else if (target == GL_DRAW_FRAMEBUFFER) {
+    track(bindings.draw_framebuffer, framebuffer);
+  } else {
+    // GL_FRAMEBUFFER sets both and is only redundant if both already match.
+    if (bindings.read_framebuffer == framebuffer && bindings.draw_framebuffer == framebuffer) {
+      ++frame_redundant;
+    }
+    bindings.read_framebuffer = bindings.draw_framebuffer = framebuffer;
+  }
+  real_glBindFramebuffer(target, framebuffer);
+}
+
+// A deleted program stays current until another one is used, so the shadow
+// is left alone.
+void APIENTRY wrap_glDeleteProgram(GLuint program) {
+  count_call(kDeleteProgram);
+  real_glDeleteProgram(program);
+}
+
+// Deleting a bound object reverts its binding points to 0.
+void APIENTRY wrap_glDeleteBuffers(GLsizei n, const GLuint* buffers) {
+  count_call(kDeleteBuffers);
+  for (GLsizei i = 0; i < n; ++i) {
+    if (bindings.array_buffer == buffers[i]) {
+      bindings.array_buffer = 0;
+    }
+    for (auto& entry : bindings.element_buffer) {
+      if (entry.second == buffers[i]) {
+        entry.second = 0;
+      }
+    }
+  }
+  real_glDeleteBuffers(n, buffers);
+}
+
+void APIENTRY wrap_glDeleteVertexArrays(GLsizei n, const GLuint* arrays) {
+  count_call(kDeleteVertexArrays);
+  for (GLsizei i = 0; i < n; ++i) {
+    if (bindings.vertex_array == arrays[i]) {
+      bindings.vertex_array = 0;
+    }
+    bindings.element_buffer.erase(arrays[i]);
+  }
+  real_glDeleteVertexArrays(n, arrays);
+}
+
+void APIENTRY wrap_glDeleteTextures(GLsizei n, const GLuint* textures) {
+  count_call(kDeleteTextures);
+  for (GLsizei i = 0; i < n; ++i) {
+    for (GLuint& bound : bindings.texture_2d) {
+      if (bound == textures[i]) {
+        bound = 0;
+      }
+    }
+  }
+  real_glDeleteTextures(n, textures);
+}
+
+} // anonymous namespace.
+
+void GlIntercept::Install() {
+  if (is_installed) {
+    return;
+  }
+#define INSTALL(kind, ret, name, params, args) \
+  real_gl##name = glad_gl##name; \
+  glad_gl##name = wrap_gl##name;
+#define INSTALL_TRACKED(kind, name) \
+  real_gl##name = glad_gl##name; \
+  glad_gl##name = wrap_gl##name;
+  GL_COUNTED_CALLS(INSTALL)
+  GL_TRACKED_CALLS(INSTALL_TRACKED)
+#undef INSTALL
+#undef INSTALL_TRACKED
+  // GlExt entries stay nullptr when the context lacks them, so callers can
+  // still test for the feature.
+  GlExt& ext = mutable_gl_ext();
+#define INSTALL_EXT(kind, ret, name, params, args) \
+  real_gl##name = ext.name; \
+  if (ext.name != nullptr) { \
+    ext.name = wrap_gl##name; \
+  }
+#define INSTALL_EXT_TRACKED(kind, name) \
+  real_gl##name = ext.name; \
+  if (ext.name != nullptr) { \
+    ext.name = wrap_gl##name; \
+  }
+  GL_EXT_COUNTED_CALLS(INSTALL_EXT)
+  GL_EXT_TRACKED_CALLS(INSTALL_EXT_TRACKED)
+#undef INSTALL_EXT
+#undef INSTALL_EXT_TRACKED
+  is_installed = true;
+}
+
+bool GlIntercept::installed() {
+  return is_installed;
+}
+
+void GlIntercept::EndFrame(Benchmark* benchmark, long frame) {
+  GlFrameCounters counters;
+  for (int i = 0; i < kNumEntries; ++i) {
+    long n = frame_counts[i];
+    counters.calls += n;
+    switch (kEntries[i].kind) {
+      case kDraw:
+        counters.draws += n;
+        break;
+      case kBind:
+        counters.binds += n;
+        counters.state_changes += n;
+        break;
+      case kState:
+      case kUniform:
+        counters.state_changes += n;
+        break;
+      default:
+        break;
+    }
+    // Zeros too, so the series describes every frame and not just the
+    // frames that made the call.
+    if (benchmark != nullptr) {
+      benchmark->Record(std::string("gl:") + kEntries[i].name, frame, n);
+    }
+    total_counts[i] += n;
+    frame_counts[i] = 0;
+  }
+  counters.redundant_binds = frame_redundant;
+  counters.state_changes -= frame_redundant;
+  if (benchmark != nullptr) {
+    benchmark->Record("gl_calls", frame, counters.calls);
+    benchmark->Record("gl_draws", frame, counters.draws);
+    benchmark->Record("gl_binds", frame, counters.binds);
+    benchmark->Record("gl_redundant_binds", frame, counters.redundant_binds);
+    benchmark->Record("gl_state_changes", frame, counters.state_changes);
+  }
+  total_redundant += frame_redundant;
+  frame_redundant = 0;
+  ++total_frames;
+  last_counters = counters;
+}
+
+const GlFrameCounters& GlIntercept::last_frame() {
+  return last_counters;
+}
+
+void GlIntercept::PrintSummary() {
+  if (total_frames == 0) {
+    return;
+  }
+  std::cout << "GL calls per frame over " << total_frames << " frames:" << std::endl;
+  for (int i = 0; i < kNumEntries; ++i) {
+    if (total_counts[i] > 0) {
+      std::cout << "  " << kEntries[i].name << ": "
+                << static_cast<double>(total_counts[i]) / total_frames << std::endl;
+    }
+  }
+  std::cout << "  redundant binds: " << static_cast<double>(total_redundant) / total_frames
+            << std::endl;
+}
+
+}
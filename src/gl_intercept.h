@@ -0,0 +1,43 @@
+#ifndef GL_INTERCEPT_H_
+#define GL_INTERCEPT_H_
+
+#include <glad/glad.h>  // include glad to get all the required OpenGL headers
+
+namespace experimentgl {
+
+class Benchmark;
+
+// Per-frame totals gathered by the interception layer.
+struct GlFrameCounters {
+  long calls = 0;
+  long draws = 0;
+  // Every bind, including the redundant ones.
+  long binds = 0;
+  // Binds of the object that was already bound to that slot.
+  long redundant_binds = 0;
+  // Non-redundant binds plus other state and uniform changes.
+  long state_changes = 0;
+};
+
+// Counts GL calls by entry point by swapping glad's function pointers
+// (glad_glUseProgram etc.) and the GlExt table for wrappers that count and
+// forward. Bind calls are checked against a shadow of the current bindings to
+// find redundant ones. Every entry point the sources call is wrapped, plus
+// common draw/state calls; a new GL call must be added to the lists in
+// gl_intercept.cpp or it goes straight to the driver uncounted.
+class GlIntercept {
+ public:
+  // Call once, after glad has loaded the context's entry points.
+  static void Install();
+  static bool installed();
+  // Closes the frame: hands its counters to 'benchmark' (may be nullptr) as
+  // "gl_*" series and "gl:<entry point>" call counts, then resets them.
+  static void EndFrame(Benchmark* benchmark, long frame);
+  // Counters of the last frame closed by EndFrame().
+  static const GlFrameCounters& last_frame();
+  // Prints per-frame averages of every entry point seen.
+  static void PrintSummary();
+};
+
+}
+#endif // GL_INTERCEPT_H_
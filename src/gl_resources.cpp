@@ -0,0 +1,181 @@
+#include "gl_resources.h"
+
+#include "benchmark.h"
+#include "gl_ext.h"
+#include "gl_state.h"
+
+#include <iostream>
+#include <string>
+
+namespace experimentgl {
+
+namespace {
+
+const char* const kNames[kNumGlResourceTypes] = {
+  "buffers", "vertex_arrays", "textures", "programs", "queries", "program_pipelines",
+};
+
+// Growth tracking of one quantity: its value at the end of the previous
+// frame, frames in the current window (cut short when the value drops), and
+// what it was when the window started. The first frame only sets the
+// baseline, so objects created during setup do not count as growth.
+struct Growth {
+  bool started = false;
+  long long previous = 0;
+  long frames = 0;
+  long long start = 0;
+
+  // Takes this frame's 'value'. Returns true when it completes a window it
+  // never dropped in and ends higher than it started.
+  bool Update(long long value) {
+    bool dropped = !started || value < previous;
+    started = true;
+    previous = value;
+    if (dropped) {
+      frames = 0;
+      start = value;
+      return false;
+    }
+    if (++frames < GlResources::kGrowthFrames) {
+      return false;
+    }
+    // Judge the next kGrowthFrames frames on their own.
+    bool grew = value > start;
+    frames = 0;
+    start = value;
+    return grew;
+  }
+};
+
+struct Counts {
+  long live = 0;
+  GLsizeiptr bytes = 0;
+  Growth live_growth;
+  Growth bytes_growth;
+};
+
+Counts counts[kNumGlResourceTypes];
+long alarm_count = 0;
+
+Counts& counts_for(GlResourceType type) {
+  return counts[static_cast<int>(type)];
+}
+
+} // anonymous namespace.
+
+void GlResources::Track(GlResourceType type) {
+  ++counts_for(type).live;
+}
+
+void GlResources::Untrack(GlResourceType type, GLsizeiptr bytes) {
+  Counts& c = counts_for(type);
+  --c.live;
+  c.bytes -= bytes;
+}
+
+void GlResources::Resize(GlResourceType type, GLsizeiptr old_bytes, GLsizeiptr new_bytes) {
+  counts_for(type).bytes += new_bytes - old_bytes;
+}
+
+long GlResources::live(GlResourceType type) {
+  return counts_for(type).live;
+}
+
+GLsizeiptr GlResources::bytes(GlResourceType type) {
+  return counts_for(type).bytes;
+}
+
+const char* GlResources::name(GlResourceType type) {
+  return kNames[static_cast<int>(type)];
+}
+
+void GlResources::EndFrame(Benchmark* benchmark, long frame) {
+  for (int i = 0; i < kNumGlResourceTypes; ++i) {
+    Counts& c = counts[i];
+    long long live_start = c.live_growth.start;
+    long long bytes_start = c.bytes_growth.start;
+    bool live_grew = c.live_growth.Update(c.live);
+    bool bytes_grew = c.bytes_growth.Update(c.bytes);
+    if (live_grew || bytes_grew) {
+      ++alarm_count;
+      std::cout << "GL resource growth: " << c.live << " " << kNames[i] << " alive ("
+                << c.bytes << " bytes), up " << c.live - live_start << " objects and "
+                << c.bytes - bytes_start << " bytes over the last " << kGrowthFrames
+                << " frames without ever dropping. Leaking?" << std::endl;
+    }
+    if (benchmark != nullptr) {
+      benchmark->Record(std::string("live:") + kNames[i], frame, c.live);
+      benchmark->Record(std::string("bytes:") + kNames[i], frame, c.bytes);
+    }
+  }
+}
+
+long GlResources::alarms() {
+  return alarm_count;
+}
+
+bool GlResources::ReportLeaks() {
+  bool clean = true;
+  for (int i = 0; i < kNumGlResourceTypes; ++i) {
+    if (counts[i].live > 0) {
+      std::cout << "GL resources still alive: " << counts[i].live << " " << kNames[i]
+                << " (" << counts[i].bytes << " bytes)" << std::endl;
+      clean = false;
+    }
+  }
+  return clean;
+}
+
+GLuint CreateGlResource(GlResourceType type) {
+  GLuint id = 0;
+  switch (type) {
+    case GlResourceType::kBuffer:
+      glGenBuffers(1, &id);
+      break;
+    case GlResourceType::kVertexArray:
+      glGenVertexArrays(1, &id);
+      break;
+    case GlResourceType::kTexture:
+      glGenTextures(1, &id);
+      break;
+    case GlResourceType::kProgram:
+      id = glCreateProgram();
+      break;
+    case GlResourceType::kQuery:
+      glGenQueries(1, &id);
+      break;
+    case GlResourceType::kProgramPipeline:
+      gl_ext().GenProgramPipelines(1, &id);
+      break;
+  }
+  if (id != 0) {
+    GlResources::Track(type);
+  }
+  return id;
+}
+
+void DeleteGlResource(GlResourceType type, GLuint id, GLsizeiptr bytes) {
+  switch (type) {
+    case GlResourceType::kBuffer:
+      GlState::DeleteBuffers(1, &id);
+      break;
+    case GlResourceType::kVertexArray:
+      GlState::DeleteVertexArrays(1, &id);
+      break;
+    case GlResourceType::kTexture:
+      GlState::DeleteTextures(1, &id);
+      break;
+    case GlResourceType::kProgram:
+      GlState::DeleteProgram(id);
+      break;
+    case GlResourceType::kQuery:
+      glDeleteQueries(1, &id);
+      break;
+    case GlResourceType::kProgramPipeline:
+      GlState::DeleteProgramPipelines(1, &id);
+      break;
+  }
+  GlResources::Untrack(type, bytes);
+}
+
+}
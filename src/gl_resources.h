@@ -0,0 +1,122 @@
+#ifndef GL_RESOURCES_H_
+#define GL_RESOURCES_H_
+
+#include <glad/glad.h>  // include glad to get all the required OpenGL headers
+
+namespace experimentgl {
+
+class Benchmark;
+
+enum class GlResourceType {
+  kBuffer,
+  kVertexArray,
+  kTexture,
+  kProgram,
+  kQuery,
+  kProgramPipeline,
+};
+const int kNumGlResourceTypes = 6;
+
+// Counts the GL objects alive right now, and the bytes of storage behind
+// them, per type. GlHandle keeps it up to date; code that owns objects some
+// other way calls Track() / Untrack() itself.
+//
+// EndFrame() samples the counts and byte totals once a frame, in windows of
+// kGrowthFrames frames. One that never drops during a window and ends it
+// higher than it started is reported as a likely leak, however slowly it
+// crept up: one object every few frames, or a buffer re-specified a little
+// larger each frame. Whatever is still alive when the context goes away is
+// reported by ReportLeaks().
+class GlResources {
+ public:
+  // Length of the window a count is judged over.
+  static const long kGrowthFrames = 120;
+
+  static void Track(GlResourceType type);
+  static void Untrack(GlResourceType type, GLsizeiptr bytes);
+  // An object's storage changed from 'old_bytes' to 'new_bytes'.
+  static void Resize(GlResourceType type, GLsizeiptr old_bytes, GLsizeiptr new_bytes);
+
+  static long live(GlResourceType type);
+  static GLsizeiptr bytes(GlResourceType type);
+  // Plural, for reports: "buffers", "vertex_arrays", ...
+  static const char* name(GlResourceType type);
+
+  // Checks the counts for growth and, if 'benchmark' is set, records them
+  // as "live:<type>" and "bytes:<type>" series for 'frame'.
+  static void EndFrame(Benchmark* benchmark, long frame);
+  // Growth reports made by EndFrame() so far.
+  static long alarms();
+  // Prints every type that still has live objects. Returns false if any do.
+  static bool ReportLeaks();
+};
+
+// glGen* / glCreateProgram for one object of 'type', tracked. 0 on failure.
+GLuint CreateGlResource(GlResourceType type);
+// Deletes 'id' through GlState where it shadows the binding, and untracks it.
+void DeleteGlResource(GlResourceType type, GLuint id, GLsizeiptr bytes);
+
+// Sole owner of one GL object; deletes it when destroyed. Move-only.
+//
+//   GlBuffer vbo = GlBuffer::Create();
+//   GlState::BindBuffer(GL_ARRAY_BUFFER, vbo.get());
+//   glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+//   vbo.SetBytes(sizeof(vertices));
+template <GlResourceType kType>
+class GlHandle {
+ public:
+  GlHandle() = default;
+  GlHandle(GlHandle&& other) noexcept : id_(other.id_), bytes_(other.bytes_) {
+    other.id_ = 0;
+    other.bytes_ = 0;
+  }
+  GlHandle& operator=(GlHandle&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      id_ = other.id_;
+      bytes_ = other.bytes_;
+      other.id_ = 0;
+      other.bytes_ = 0;
+    }
+    return *this;
+  }
+  GlHandle(const GlHandle&) = delete;
+  GlHandle& operator=(const GlHandle&) = delete;
+  ~GlHandle() { Reset(); }
+
+  // A new object. Empty if GL could not create one.
+  static GlHandle Create() { return GlHandle(CreateGlResource(kType)); }
+
+  GLuint get() const { return id_; }
+  explicit operator bool() const { return id_ != 0; }
+  GLsizeiptr bytes() const { return bytes_; }
+  // Records the size of the object's storage once it is (re)specified.
+  void SetBytes(GLsizeiptr bytes) {
+    GlResources::Resize(kType, bytes_, bytes);
+    bytes_ = bytes;
+  }
+  // Deletes the object now, leaving the handle empty.
+  void Reset() {
+    if (id_ != 0) {
+      DeleteGlResource(kType, id_, bytes_);
+    }
+    id_ = 0;
+    bytes_ = 0;
+  }
+
+ private:
+  explicit GlHandle(GLuint id) : id_(id) {}
+
+  GLuint id_ = 0;
+  GLsizeiptr bytes_ = 0;
+};
+
+using GlBuffer = GlHandle<GlResourceType::kBuffer>;
+using GlVertexArray = GlHandle<GlResourceType::kVertexArray>;
+using GlTexture = GlHandle<GlResourceType::kTexture>;
+using GlProgram = GlHandle<GlResourceType::kProgram>;
+using GlQuery = GlHandle<GlResourceType::kQuery>;
+using GlProgramPipeline = GlHandle<GlResourceType::kProgramPipeline>;
+
+}
+#endif // GL_RESOURCES_H_
@@ -0,0 +1,261 @@
+#include "gl_state.h"
+
+#include "gl_ext.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace experimentgl {
+
+namespace {
+
+// Shadow value for a binding we know nothing about.
+const GLuint kUnknown = ~0u;
+const int kMaxTextureUnits = 32;
+// Texture targets shadowed per unit; others are passed through.
+const GLenum kTextureTargets[] = {
+  GL_TEXTURE_2D, GL_TEXTURE_3D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY,
+};
+const int kNumTextureTargets = sizeof(kTextureTargets) / sizeof(kTextureTargets[0]);
+
+// What an indexed binding point refers to. A size of -1 means the whole
+// buffer (glBindBufferBase).
+struct BufferRange {
+  GLuint buffer;
+  GLintptr offset;
+  GLsizeiptr size;
+};
+
+struct State {
+  GLuint program;
+  GLuint pipeline;
+  GLuint vertex_array;
+  GLuint array_buffer;
+  GLuint uniform_buffer;
+  // GL_ELEMENT_ARRAY_BUFFER is VAO state, so it is remembered per VAO.
+  std::unordered_map<GLuint, GLuint> element_buffer;
+  // Indexed GL_UNIFORM_BUFFER binding point -> buffer range.
+  std::unordered_map<GLuint, BufferRange> uniform_bindings;
+  GLuint active_unit;
+  GLuint textures[kMaxTextureUnits][kNumTextureTargets];
+  GLint viewport[4];
+  bool viewport_known;
+} state;
+
+long skipped = 0;
+
+int texture_target_index(GLenum target) {
+  for (int i = 0; i < kNumTextureTargets; ++i) {
+    if (kTextureTargets[i] == target) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Updates 'shadow' and returns true if the call has to reach the driver.
+bool changes(GLuint& shadow, GLuint value) {
+  if (shadow == value) {
+    ++skipped;
+    return false;
+  }
+  shadow = value;
+  return true;
+}
+
+// Like changes(), for the uniform buffer binding point 'index'.
+bool changes_range(GLuint index, const BufferRange& range) {
+  auto inserted = state.uniform_bindings.emplace(index, BufferRange{kUnknown, 0, 0});
+  BufferRange& shadow = inserted.first->second;
+  if (shadow.buffer == range.buffer && shadow.offset == range.offset &&
+      shadow.size == range.size) {
+    ++skipped;
+    return false;
+  }
+  shadow = range;
+  return true;
+}
+
+// Initialize to unknown before main() runs.
+struct Initializer {
+  Initializer() { GlState::Invalidate(); }
+} initializer;
+
+} // anonymous namespace.
+
+void GlState::UseProgram(GLuint program) {
+  if (changes(state.program, program)) {
+    glUseProgram(program);
+  }
+}
+
+void GlState::BindProgramPipeline(GLuint pipeline) {
+  if (changes(state.pipeline, pipeline)) {
+    gl_ext().BindProgramPipeline(pipeline);
+  }
+}
+
+void GlState::BindVertexArray(GLuint vertex_array) {
+  if (changes(state.vertex_array, vertex_array)) {
+    glBindVertexArray(vertex_array);
+  }
+}
+
+void GlState::BindBuffer(GLenum target, GLuint buffer) {
+  switch (target) {
+    case GL_ARRAY_BUFFER:
+      if (changes(state.array_buffer, buffer)) {
+        glBindBuffer(target, buffer);
+      }
+      return;
+    case GL_UNIFORM_BUFFER:
+      if (changes(state.uniform_buffer, buffer)) {
+        glBindBuffer(target, buffer);
+      }
+      return;
+    case GL_ELEMENT_ARRAY_BUFFER:
+      if (state.vertex_array != kUnknown) {
+        auto inserted = state.element_buffer.emplace(state.vertex_array, kUnknown);
+        if (!changes(inserted.first->second, buffer)) {
+          return;
+        }
+      }
+      glBindBuffer(target, buffer);
+      return;
+    default:
+      glBindBuffer(target, buffer);
+  }
+}
+
+void GlState::BindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+  if (target == GL_UNIFORM_BUFFER && !changes_range(index, BufferRange{buffer, 0, -1})) {
+    return;
+  }
+  glBindBufferBase(target, index, buffer);
+  if (target == GL_UNIFORM_BUFFER) {
+    state.uniform_buffer = buffer;
+  }
+}
+
+void GlState::BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset,
+                              GLsizeiptr size) {
+  if (target == GL_UNIFORM_BUFFER && !changes_range(index, BufferRange{buffer, offset, size})) {
+    return;
+  }
+  glBindBufferRange(target, index, buffer, offset, size);
+  if (target == GL_UNIFORM_BUFFER) {
+    state.uniform_buffer = buffer;
+  }
+}
+
+void GlState::BindTexture(GLuint unit, GLenum target, GLuint texture) {
+  int index = texture_target_index(target);
+  if (index >= 0 && unit < kMaxTextureUnits && state.textures[unit][index] == texture) {
+    ++skipped;
+    return;
+  }
+  if (changes(state.active_unit, unit)) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+  }
+  if (index >= 0 && unit < kMaxTextureUnits) {
+    state.textures[unit][index] = texture;
+  }
+  glBindTexture(target, texture);
+}
+
+void GlState::Viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+  GLint viewport[4] = {x, y, width, height};
+  if (state.viewport_known && std::equal(viewport, viewport + 4, state.viewport)) {
+    ++skipped;
+    return;
+  }
+  std::copy(viewport, viewport + 4, state.viewport);
+  state.viewport_known = true;
+  glViewport(x, y, width, height);
+}
+
+void GlState::DeleteProgram(GLuint program) {
+  // The program stays in use until replaced, but its name may come back.
+  if (state.program == program) {
+    state.program = kUnknown;
+  }
+  glDeleteProgram(program);
+}
+
+void GlState::DeleteProgramPipelines(GLsizei n, const GLuint* pipelines) {
+  for (GLsizei i = 0; i < n; ++i) {
+    if (state.pipeline == pipelines[i]) {
+      // Deleting the bound pipeline reverts the binding to 0.
+      state.pipeline = 0;
+    }
+  }
+  gl_ext().DeleteProgramPipelines(n, pipelines);
+}
+
+void GlState::DeleteVertexArrays(GLsizei n, const GLuint* vertex_arrays) {
+  for (GLsizei i = 0; i < n; ++i) {
+    if (state.vertex_array == vertex_arrays[i]) {
+      // Deleting the bound VAO reverts to the default one.
+      state.vertex_array = 0;
+    }
+    state.element_buffer.erase(vertex_arrays[i]);
+  }
+  glDeleteVertexArrays(n, vertex_arrays);
+}
+
+void GlState::DeleteBuffers(GLsizei n, const GLuint* buffers) {
+  for (GLsizei i = 0; i < n; ++i) {
+    // Deleting a bound buffer reverts its binding points to 0.
+    if (state.array_buffer == buffers[i]) {
+      state.array_buffer = 0;
+    }
+    if (state.uniform_buffer == buffers[i]) {
+      state.uniform_buffer = 0;
+    }
+    for (auto& entry : state.uniform_bindings) {
+      if (entry.second.buffer == buffers[i]) {
+        entry.second = BufferRange{0, 0, -1};
+      }
+    }
+    for (auto& entry : state.element_buffer) {
+      if (entry.second == buffers[i]) {
+        entry.second = 0;
+      }
+    }
+  }
+  glDeleteBuffers(n, buffers);
+}
+
+void GlState::DeleteTextures(GLsizei n, const GLuint* textures) {
+  for (GLsizei i = 0; i < n; ++i) {
+    for (auto& unit : state.textures) {
+      for (GLuint& bound : unit) {
+        if (bound == textures[i]) {
+          bound = 0;
+        }
+      }
+    }
+  }
+  glDeleteTextures(n, textures);
+}
+
+void GlState::Invalidate() {
+  state.program = kUnknown;
+  state.pipeline = kUnknown;
+  state.vertex_array = kUnknown;
+  state.array_buffer = kUnknown;
+  state.uniform_buffer = kUnknown;
+  state.element_buffer.clear();
+  state.uniform_bindings.clear();
+  state.active_unit = kUnknown;
+  for (auto& unit : state.textures) {
+    std::fill(unit, unit + kNumTextureTargets, kUnknown);
+  }
+  state.viewport_known = false;
+}
+
+long GlState::skipped_calls() {
+  return skipped;
+}
+
+}
@@ -0,0 +1,48 @@
+#ifndef GL_STATE_H_
+#define GL_STATE_H_
+
+#include <glad/glad.h>  // include glad to get all the required OpenGL headers
+
+namespace experimentgl {
+
+// Shadows the current GL bindings and drops calls that would not change them.
+// Covers the program and program pipeline, VAO, GL_ARRAY_BUFFER / GL_UNIFORM_BUFFER, the element
+// buffer of each VAO, indexed uniform buffer bindings, textures per unit and
+// the viewport. Everything starts
+// out unknown, so the first call of each kind always reaches the driver.
+//
+// Code that changes these bindings behind the tracker's back must call
+// Invalidate(), and objects must be deleted through the Delete*() helpers so
+// a recycled name is not mistaken for the binding it replaced.
+class GlState {
+ public:
+  static void UseProgram(GLuint program);
+  // A bound program overrides the pipeline, so callers bind program 0 first.
+  static void BindProgramPipeline(GLuint pipeline);
+  static void BindVertexArray(GLuint vertex_array);
+  // Other targets than the tracked ones go straight to the driver.
+  static void BindBuffer(GLenum target, GLuint buffer);
+  // glBindBufferBase, which also binds 'buffer' to the generic 'target'.
+  static void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+  // glBindBufferRange, which also binds 'buffer' to the generic 'target'.
+  static void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset,
+                              GLsizeiptr size);
+  // Binds 'texture' to texture unit 'unit' (0-based), switching the active
+  // unit only when needed.
+  static void BindTexture(GLuint unit, GLenum target, GLuint texture);
+  static void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+  static void DeleteProgram(GLuint program);
+  static void DeleteProgramPipelines(GLsizei n, const GLuint* pipelines);
+  static void DeleteVertexArrays(GLsizei n, const GLuint* vertex_arrays);
+  static void DeleteBuffers(GLsizei n, const GLuint* buffers);
+  static void DeleteTextures(GLsizei n, const GLuint* textures);
+
+  // Forgets every shadowed binding.
+  static void Invalidate();
+  // Calls dropped because they would not have changed anything.
+  static long skipped_calls();
+};
+
+}
+#endif // GL_STATE_H_
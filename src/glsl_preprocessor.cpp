@@ -0,0 +1,188 @@
+#include "glsl_preprocessor.h"
+
+#include "shader_files.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace experimentgl {
+
+namespace {
+
+std::string directory_of(const std::string& path) {
+  size_t slash = path.rfind('/');
+  return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+// If 'line' is '#include "name"' (whitespace allowed around '#'), stores the
+// name and returns true.
+bool parse_include(std::string_view line, std::string* name) {
+  size_t pos = line.find_first_not_of(" \t");
+  if (pos == std::string_view::npos || line[pos] != '#') {
+    return false;
+  }
+  pos = line.find_first_not_of(" \t", pos + 1);
+  if (pos == std::string_view::npos || line.compare(pos, 7, "include") != 0) {
+    return false;
+  }
+  size_t open = line.find('"', pos + 7);
+  size_t close = open == std::string_view::npos ? open : line.find('"', open + 1);
+  if (close == std::string_view::npos) {
+    return false;
+  }
+  name->assign(line.substr(open + 1, close - open - 1));
+  return true;
+}
+
+bool is_version(std::string_view line) {
+  size_t pos = line.find_first_not_of(" \t");
+  return pos != std::string_view::npos && line.compare(pos, 8, "#version") == 0;
+}
+
+// Splits a declaration like "uniform float x;" into words, dropping the ';'.
+// Returns false if the line is anything else.
+bool split_declaration(const std::string& line, std::vector<std::string>* words) {
+  size_t semicolon = line.find(';');
+  if (semicolon == std::string::npos ||
+      line.find_first_not_of(" \t", semicolon + 1) != std::string::npos) {
+    return false;
+  }
+  std::istringstream in(line.substr(0, semicolon));
+  std::string word;
+  while (in >> word) {
+    words->push_back(word);
+  }
+  return !words->empty() && words->front() == "uniform";
+}
+
+void append_defines(const ShaderDefines& defines, std::string* text) {
+  for (const auto& define : defines) {
+    *text += "#define " + define.first + " " + define.second + "\n";
+  }
+}
+
+// Appends the expansion of 'path' to source->text.
+bool expand(const std::string& path, const ShaderDefines& defines, bool root,
+            GlslSource* source) {
+  // Lines are appended straight from the mapped or embedded file.
+  ShaderFile file = ShaderFiles::Open(path);
+  if (!file.found()) {
+    std::cout << "Could not read shader source " << path << std::endl;
+    return false;
+  }
+  std::string_view contents = file.contents();
+  int index = source->files.size();
+  source->files.push_back(path);
+  // #version must come first; without one the defines do.
+  bool defines_pending = root && !defines.empty();
+  if (defines_pending && contents.find("#version") == std::string_view::npos) {
+    append_defines(defines, &source->text);
+    source->text += "#line 1 0\n";
+    defines_pending = false;
+  }
+  source->text.reserve(source->text.size() + contents.size());
+  size_t begin = 0;
+  for (int number = 1; begin < contents.size(); ++number) {
+    size_t end = contents.find('\n', begin);
+    if (end == std::string_view::npos) {
+      end = contents.size();
+    }
+    std::string_view line = contents.substr(begin, end - begin);
+    begin = end + 1;
+    std::string name;
+    if (parse_include(line, &name)) {
+      std::string included = directory_of(path) + name;
+      if (std::find(source->files.begin(), source->files.end(), included) == source->files.end()) {
+        source->text += "#line 1 " + std::to_string(source->files.size()) + "\n";
+        if (!expand(included, defines, false, source)) {
+          std::cout << "  included from " << path << ":" << number << std::endl;
+          return false;
+        }
+      }
+      source->text += "#line " + std::to_string(number + 1) + " " + std::to_string(index) + "\n";
+      continue;
+    }
+    source->text += line;
+    source->text += '\n';
+    if (defines_pending && is_version(line)) {
+      append_defines(defines, &source->text);
+      source->text += "#line " + std::to_string(number + 1) + " 0\n";
+      defines_pending = false;
+    }
+  }
+  return true;
+}
+
+} // anonymous namespace.
+
+bool PreprocessGlsl(const std::string& path, const ShaderDefines& defines, GlslSource* source) {
+  source->text.clear();
+  source->files.clear();
+  return expand(path, defines, true, source);
+}
+
+std::string DefinesKey(const ShaderDefines& defines) {
+  std::string key;
+  for (const auto& define : defines) {
+    key += define.first + " " + define.second + "\n";
+  }
+  return key;
+}
+
+UniformConstants& UniformConstants::Set(const std::string& name, float value) {
+  std::ostringstream literal;
+  literal << std::setprecision(std::numeric_limits<float>::max_digits10) << value;
+  std::string text = literal.str();
+  // GLSL reads "1" as an int.
+  if (text.find_first_of(".e") == std::string::npos) {
+    text += ".0";
+  }
+  return SetExpression(name, text);
+}
+
+UniformConstants& UniformConstants::Set(const std::string& name, int value) {
+  return SetExpression(name, std::to_string(value));
+}
+
+UniformConstants& UniformConstants::Set(const std::string& name, bool value) {
+  return SetExpression(name, value ? "true" : "false");
+}
+
+UniformConstants& UniformConstants::SetExpression(const std::string& name,
+                                                  const std::string& expression) {
+  values_[name] = expression;
+  return *this;
+}
+
+void BakeUniforms(const UniformConstants& constants, GlslSource* source,
+                  std::set<std::string>* baked) {
+  std::istringstream lines(source->text);
+  std::string text;
+  std::string line;
+  while (std::getline(lines, line)) {
+    std::vector<std::string> words;
+    // "uniform [precision] type name", so the name is always last.
+    if (split_declaration(line, &words) && words.size() >= 3) {
+      auto value = constants.values().find(words.back());
+      if (value != constants.values().end()) {
+        words.front() = "const";
+        for (const std::string& word : words) {
+          text += word + " ";
+        }
+        text += "= " + value->second + ";\n";
+        baked->insert(value->first);
+        continue;
+      }
+    }
+    text += line;
+    text += '\n';
+  }
+  source->text = std::move(text);
+}
+
+}
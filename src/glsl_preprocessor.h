@@ -0,0 +1,59 @@
+#ifndef GLSL_PREPROCESSOR_H_
+#define GLSL_PREPROCESSOR_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace experimentgl {
+
+// #defines injected into a shader variant, e.g. {"COLOR", "vec4(1.0)"}. Kept
+// sorted by name so equal sets always produce the same source and key.
+using ShaderDefines = std::map<std::string, std::string>;
+
+// A preprocessed shader stage, ready for glShaderSource.
+struct GlslSource {
+  std::string text;
+  // Every file read, the root first. The #line directives in 'text' refer to
+  // files by their index here, so compile errors read "<index>:<line>(col)".
+  std::vector<std::string> files;
+};
+
+// Reads the shader at 'path' (through ShaderFiles) and expands it:
+// - '#include "file"' lines are replaced by that file, resolved relative to
+//   the including file. A file is included at most once, like #pragma once.
+// - 'defines' are inserted as #define lines right after #version.
+// Returns false, after printing why, if a file cannot be read.
+bool PreprocessGlsl(const std::string& path, const ShaderDefines& defines, GlslSource* source);
+
+// Canonical text form of 'defines', usable as a variant key.
+std::string DefinesKey(const ShaderDefines& defines);
+
+// Uniform values to bake into a shader as constants, see BakeUniforms().
+class UniformConstants {
+ public:
+  UniformConstants& Set(const std::string& name, float value);
+  UniformConstants& Set(const std::string& name, int value);
+  UniformConstants& Set(const std::string& name, bool value);
+  // 'expression' is GLSL of the uniform's type, e.g. "vec2(0.5, 1.0)".
+  UniformConstants& SetExpression(const std::string& name, const std::string& expression);
+
+  bool empty() const { return values_.empty(); }
+  // Uniform name -> GLSL expression, sorted by name.
+  const std::map<std::string, std::string>& values() const { return values_; }
+  // Canonical text form, usable as a variant key.
+  std::string key() const { return DefinesKey(values_); }
+
+ private:
+  std::map<std::string, std::string> values_;
+};
+
+// Rewrites each 'uniform T name;' declaration in 'source' whose name is in
+// 'constants' to 'const T name = value;', so the driver can fold the value.
+// Only single declarations are rewritten; names found are added to 'baked'.
+void BakeUniforms(const UniformConstants& constants, GlslSource* source,
+                  std::set<std::string>* baked);
+
+}
+#endif // GLSL_PREPROCESSOR_H_
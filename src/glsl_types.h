@@ -0,0 +1,34 @@
+#ifndef GLSL_TYPES_H_
+#define GLSL_TYPES_H_
+
+namespace experimentgl {
+
+// Plain C++ twins of the GLSL vector and matrix types, laid out exactly like
+// the float arrays GL reads them from. They carry no alignment of their own;
+// the std140 rules are checked where they are used (see uniform_block.h).
+struct Vec2 {
+  float x, y;
+};
+
+struct Vec3 {
+  float x, y, z;
+};
+
+struct Vec4 {
+  float x, y, z, w;
+};
+
+// Column-major, like GLSL: m[column * 4 + row].
+struct Mat4 {
+  float m[16];
+
+  static Mat4 Identity() {
+    return Mat4{{1.0f, 0.0f, 0.0f, 0.0f,
+                 0.0f, 1.0f, 0.0f, 0.0f,
+                 0.0f, 0.0f, 1.0f, 0.0f,
+                 0.0f, 0.0f, 0.0f, 1.0f}};
+  }
+};
+
+}
+#endif // GLSL_TYPES_H_
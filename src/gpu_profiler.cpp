@@ -0,0 +1,186 @@
+#include "gpu_profiler.h"
+
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace experimentgl {
+
+namespace {
+
+GpuProfiler* current_profiler = nullptr;
+
+} // anonymous namespace.
+
+GpuProfiler::GpuProfiler(int frames_in_flight, int max_scopes)
+    : frames_in_flight_(frames_in_flight), max_scopes_(max_scopes),
+      queries_(frames_in_flight * 2 * max_scopes), frames_(frames_in_flight) {}
+
+std::unique_ptr<GpuProfiler> GpuProfiler::Create(int frames_in_flight, int max_scopes) {
+  if (frames_in_flight < 1 || max_scopes < 1) {
+    std::cout << "Invalid GPU profiler size" << std::endl;
+    return nullptr;
+  }
+  std::unique_ptr<GpuProfiler> p(new GpuProfiler(frames_in_flight, max_scopes));
+  for (GlQuery& query : p->queries_) {
+    query = GlQuery::Create();
+  }
+  return p;
+}
+
+GpuProfiler::~GpuProfiler() {
+  if (current_profiler == this) {
+    current_profiler = nullptr;
+  }
+}
+
+GpuProfiler* GpuProfiler::current() {
+  return current_profiler;
+}
+
+void GpuProfiler::set_current(GpuProfiler* profiler) {
+  current_profiler = profiler;
+}
+
+unsigned int GpuProfiler::query(const Frame& slot, int index) const {
+  return queries_[(&slot - frames_.data()) * 2 * max_scopes_ + index].get();
+}
+
+void GpuProfiler::BeginFrame(long frame) {
+  Frame& slot = frames_[frame % frames_in_flight_];
+  if (slot.frame >= 0 && !Collect(slot, /*wait=*/false)) {
+    ++dropped_frames_;
+  }
+  slot.frame = frame;
+  slot.scopes.clear();
+  slot.next_query = 0;
+  current_frame_ = &slot;
+}
+
+void GpuProfiler::EndFrame() {
+  current_frame_ = nullptr;
+}
+
+void GpuProfiler::Flush() {
+  // The frame begun after the last present was never rendered; free its
+  // slot rather than report it.
+  if (current_frame_ != nullptr) {
+    current_frame_->frame = -1;
+    current_frame_->scopes.clear();
+    current_frame_ = nullptr;
+  }
+  // Oldest first, so the benchmark sees frames in order.
+  std::vector<Frame*> pending;
+  for (Frame& slot : frames_) {
+    if (slot.frame >= 0) {
+      pending.push_back(&slot);
+    }
+  }
+  std::sort(pending.begin(), pending.end(),
+            [](const Frame* a, const Frame* b) { return a->frame < b->frame; });
+  for (Frame* slot : pending) {
+    Collect(*slot, /*wait=*/true);
+  }
+}
+
+int GpuProfiler::Begin(const char* name) {
+  if (current_frame_ == nullptr || current_frame_->next_query + 2 > 2 * max_scopes_) {
+    return -1;
+  }
+  Scope scope = {name, current_frame_->next_query, -1};
+  current_frame_->next_query += 2;
+  glQueryCounter(query(*current_frame_, scope.begin_query), GL_TIMESTAMP);
+  current_frame_->scopes.push_back(scope);
+  return current_frame_->scopes.size() - 1;
+}
+
+void GpuProfiler::End(int scope) {
+  if (current_frame_ == nullptr || scope < 0) {
+    return;
+  }
+  Scope& s = current_frame_->scopes[scope];
+  s.end_query = s.begin_query + 1;
+  glQueryCounter(query(*current_frame_, s.end_query), GL_TIMESTAMP);
+}
+
+bool GpuProfiler::Collect(Frame& slot, bool wait) {
+  // Timestamps complete in submission order, so the last one tells us whether
+  // the whole frame is done.
+  int last = -1;
+  for (const Scope& s : slot.scopes) {
+    if (s.end_query > last) {
+      last = s.end_query;
+    }
+  }
+  if (last >= 0 && !wait) {
+    int available = 0;
+    glGetQueryObjectiv(query(slot, last), GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+      return false;
+    }
+  }
+
+  latest_.clear();
+  for (const Scope& s : slot.scopes) {
+    if (s.end_query < 0) {
+      // Scope was still open when the frame ended.
+      continue;
+    }
+    GLuint64 begin = 0, end = 0;
+    glGetQueryObjectui64v(query(slot, s.begin_query), GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(query(slot, s.end_query), GL_QUERY_RESULT, &end);
+    double ms = (end - begin) / 1e6;
+    ScopeTiming* timing = nullptr;
+    for (ScopeTiming& t : latest_) {
+      if (std::strcmp(t.name, s.name) == 0) {
+        timing = &t;
+        break;
+      }
+    }
+    if (timing == nullptr) {
+      latest_.push_back({s.name, 0.0, 0});
+      timing = &latest_.back();
+    }
+    timing->ms += ms;
+    ++timing->calls;
+  }
+
+  for (const ScopeTiming& t : latest_) {
+    ScopeTiming& total = totals_.emplace(t.name, ScopeTiming{t.name, 0.0, 0}).first->second;
+    total.ms += t.ms;
+    ++total.calls;
+    if (benchmark_ != nullptr) {
+      benchmark_->Record(std::string("gpu:") + t.name, slot.frame, t.ms);
+    }
+  }
+  ++collected_frames_;
+  slot.frame = -1;
+  return true;
+}
+
+void GpuProfiler::PrintSummary() const {
+  std::cout << "GPU scopes over " << collected_frames_ << " frames (" << dropped_frames_
+            << " dropped):" << std::endl;
+  for (const auto& entry : totals_) {
+    // 'calls' counts frames the scope appeared in.
+    std::cout << "  " << entry.first << ": " << entry.second.ms / entry.second.calls
+              << " ms/frame" << std::endl;
+  }
+}
+
+GpuScope::GpuScope(const char* name)
+    : profiler_(GpuProfiler::current()),
+      scope_(profiler_ != nullptr ? profiler_->Begin(name) : -1) {}
+
+GpuScope::~GpuScope() {
+  if (profiler_ != nullptr) {
+    profiler_->End(scope_);
+  }
+}
+
+}
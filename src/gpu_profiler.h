@@ -0,0 +1,107 @@
+#ifndef GPU_PROFILER_H_
+#define GPU_PROFILER_H_
+
+#include <glad/glad.h>  // include glad to get all the required OpenGL headers
+
+#include "gl_resources.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace experimentgl {
+
+class Benchmark;
+
+// Times named regions of GL work with GL_TIMESTAMP queries. Every frame gets
+// its own set of queries from a ring 'frames_in_flight' deep, and a frame's
+// results are only read when its slot comes round again. If the GPU is still
+// behind by then the frame's results are dropped instead of waited for, so
+// profiling never stalls the render loop.
+class GpuProfiler {
+ public:
+  struct ScopeTiming {
+    // Points at the name the scope was opened with.
+    const char* name;
+    // Sum over every time the scope was entered during the frame.
+    double ms;
+    int calls;
+  };
+
+  static std::unique_ptr<GpuProfiler> Create(int frames_in_flight = 3, int max_scopes = 64);
+  ~GpuProfiler();
+
+  // The profiler GpuScope reports to; nullptr turns scopes into no-ops.
+  static GpuProfiler* current();
+  static void set_current(GpuProfiler* profiler);
+
+  // Bracket the GL work of frame 'frame'.
+  void BeginFrame(long frame);
+  void EndFrame();
+  // Waits for every ended frame still in flight and reads it back; a frame
+  // begun but not ended is dropped. Meant for shutdown, when stalling no
+  // longer matters.
+  void Flush();
+  // Returns a handle for End(), or -1 if the frame ran out of queries.
+  int Begin(const char* name);
+  void End(int scope);
+
+  // Per-scope timings of the latest frame that was read back.
+  const std::vector<ScopeTiming>& latest() const { return latest_; }
+  // Frames whose results were not ready in time and were dropped.
+  long dropped_frames() const { return dropped_frames_; }
+  // Also report each scope as a "gpu:<name>" series.
+  void set_benchmark(Benchmark* benchmark) { benchmark_ = benchmark; }
+  // Prints the average time of every scope seen so far.
+  void PrintSummary() const;
+
+ private:
+  struct Scope {
+    const char* name;
+    int begin_query;
+    int end_query;
+  };
+  struct Frame {
+    long frame = -1;
+    std::vector<Scope> scopes;
+    int next_query = 0;
+  };
+
+  GpuProfiler(int frames_in_flight, int max_scopes);
+  // Reads back 'slot', waiting for its queries if 'wait' is set. Returns false
+  // if they are not done yet.
+  bool Collect(Frame& slot, bool wait);
+  unsigned int query(const Frame& slot, int index) const;
+
+  int frames_in_flight_;
+  int max_scopes_;
+  // frames_in_flight_ * 2 * max_scopes_ query objects, one block per slot.
+  std::vector<GlQuery> queries_;
+  std::vector<Frame> frames_;
+  Frame* current_frame_ = nullptr;
+  std::vector<ScopeTiming> latest_;
+  long dropped_frames_ = 0;
+  Benchmark* benchmark_ = nullptr;
+  // Running totals for PrintSummary(), keyed by scope name.
+  std::map<std::string, ScopeTiming> totals_;
+  long collected_frames_ = 0;
+};
+
+// Times the GL commands issued during its lifetime:
+//   { GpuScope scope("draw"); glDrawElements(...); }
+// 'name' must outlive the frame, e.g. a string literal.
+class GpuScope {
+ public:
+  explicit GpuScope(const char* name);
+  ~GpuScope();
+  GpuScope(const GpuScope&) = delete;
+  GpuScope& operator=(const GpuScope&) = delete;
+
+ private:
+  GpuProfiler* profiler_;
+  int scope_;
+};
+
+}
+#endif // GPU_PROFILER_H_
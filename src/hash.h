@@ -0,0 +1,28 @@
+#ifndef HASH_H_
+#define HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace experimentgl {
+
+const uint64_t kFnv64Offset = 0xcbf29ce484222325ull;
+const uint64_t kFnv64Prime = 0x100000001b3ull;
+
+// 64-bit FNV-1a. Pass a previous result as 'seed' to hash several pieces as
+// if they were one.
+constexpr uint64_t Fnv1a64(const char* data, size_t size, uint64_t seed = kFnv64Offset) {
+  uint64_t hash = seed;
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(data[i])) * kFnv64Prime;
+  }
+  return hash;
+}
+
+inline uint64_t Fnv1a64(const std::string& s, uint64_t seed = kFnv64Offset) {
+  return Fnv1a64(s.data(), s.size(), seed);
+}
+
+}
+#endif // HASH_H_
@@ -0,0 +1,66 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+namespace experimentgl {
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(other.data_), size_(other.size_), valid_(other.valid_) {
+  other.data_ = nullptr;
+  other.size_ = 0;
+  other.valid_ = false;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    Unmap();
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(valid_, other.valid_);
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() {
+  Unmap();
+}
+
+void MappedFile::Unmap() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  valid_ = false;
+}
+
+MappedFile MappedFile::Open(const std::string& path) {
+  MappedFile file;
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return file;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+    if (st.st_size == 0) {
+      file.valid_ = true;
+    } else {
+      // The mapping keeps the file alive; the descriptor is not needed.
+      void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED) {
+        file.data_ = data;
+        file.size_ = st.st_size;
+        file.valid_ = true;
+      }
+    }
+  }
+  close(fd);
+  return file;
+}
+
+}
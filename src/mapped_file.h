@@ -0,0 +1,42 @@
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace experimentgl {
+
+// A file mapped read-only into memory. Its bytes are read straight from the
+// page cache: nothing is copied or allocated, and pages are only faulted in
+// as they are touched. Move-only; the mapping goes away with the object.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+
+  // Maps 'path'. The result is not valid() if the file cannot be opened.
+  static MappedFile Open(const std::string& path);
+
+  bool valid() const { return valid_; }
+  const unsigned char* data() const { return static_cast<const unsigned char*>(data_); }
+  size_t size() const { return size_; }
+  std::string_view contents() const {
+    return std::string_view(static_cast<const char*>(data_), size_);
+  }
+
+ private:
+  void Unmap();
+
+  // nullptr for empty files, which cannot be mapped but are valid.
+  void* data_ = nullptr;
+  size_t size_ = 0;
+  bool valid_ = false;
+};
+
+}
+#endif // MAPPED_FILE_H_
@@ -1,134 +1,152 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "context.h"
+#include "gl_state.h"
 #include "shader.h"
+#include "trace.h"
+#include "vertex_format.h"
+#include "vertex_stream.h"
 
 #include <iostream>
 #include <cmath>
 
-void framebuffer_size_callback(GLFWwindow* window, int width, int height);
-void processInput(GLFWwindow *window);
+using experimentgl::Context;
+using experimentgl::ContextOptions;
+using experimentgl::GlState;
+using experimentgl::MatchesVertexFormat;
+using experimentgl::ParseContextOptions;
+using experimentgl::Shader;
+using experimentgl::UniformConstants;
+using experimentgl::Vec3;
+using experimentgl::VertexAttribute;
+using experimentgl::VertexFormatOf;
+using experimentgl::VertexStream;
+
+// Layout of one vertex: position then color, as in vertex_shaders/triangle.vs.
+struct Vertex {
+    Vec3 position;
+    Vec3 color;
+};
+
+template <>
+struct experimentgl::VertexLayout<Vertex> {
+    static constexpr VertexAttribute kAttributes[] = {
+        VERTEX_ATTRIBUTE(Vertex, position, 0, "aPos"),
+        VERTEX_ATTRIBUTE(Vertex, color, 1, "aColor"),
+    };
+};
+
+void processInput(Context *context);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
-using experimentgl::Shader;
 
-int main()
+int main(int argc, char** argv)
 {
-    // glfw: initialize and configure
-    // ------------------------------
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    // glfw window creation
-    // --------------------
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Experiments", NULL, NULL);
-    if (window == NULL)
+    // Create the GL context: a GLFW window, or an offscreen FBO with --headless.
+    // --------------------------------------------------------------------------
+    ContextOptions options;
+    options.width = SCR_WIDTH;
+    options.height = SCR_HEIGHT;
+    options.title = "Experiments";
+    std::unique_ptr<Context> context = Context::Create(ParseContextOptions(argc, argv, options));
+    if (context == nullptr)
     {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
         return -1;
     }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
-    // glad: load all OpenGL function pointers
-    // ---------------------------------------
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    std::unique_ptr<Shader> base_shader = Shader::Create("vertex_shaders/triangle.vs", "fragment_shaders/triangle.fs");
+    if (base_shader == nullptr)
+    {
+        return -1;
+    }
+    // rightShiftOffset never changes: bake it into a variant instead of
+    // uploading it every frame.
+    Shader* shader = base_shader->Specialize(UniformConstants().Set("rightShiftOffset", 0.25f));
+    if (shader == nullptr)
     {
-        std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
 
-    std::unique_ptr<Shader> shader = Shader::Create("vertex_shaders/triangle.vs", "fragment_shaders/triangle.fs");
-    shader->use();
+    // One triangle a frame, streamed through a ring instead of a new
+    // VAO and VBO every frame.
+    std::unique_ptr<VertexStream> stream = VertexStream::Create<Vertex>(3);
+    if (stream == nullptr || !MatchesVertexFormat(shader->reflection(), VertexFormatOf<Vertex>()))
+    {
+        return -1;
+    }
 
     // render loop
     // -----------
-    while (!glfwWindowShouldClose(window))
+    while (!context->ShouldClose())
     {
       // input
       // -----
-      processInput(window);
-
-      // Do processing.
-      // Give the uniform var "ourValue" its value.
-      float tv1 = glfwGetTime();
-      float r1 = (sin(tv1) / 2.0f) + 0.5f;
-      float g1 = (cos(tv1) / 2.0f) + 0.5f;
-      float b1 = (sin(tv1 * 2) / 2.0f) + 0.5f;
-      float tv2 = glfwGetTime();
-      float r2 = (cos(tv2) / 2.0f) + 0.5f;
-      float g2 = (sin(tv2) / 2.0f) + 0.5f;
-      float b2 = (cos(tv2 * 2) / 2.0f) + 0.5f;
-
-      float vertices[] = {
+      {
+        TRACE_SCOPE("processInput");
+        processInput(context.get());
+      }
+
+      GLint first = 0;
+      {
+        TRACE_SCOPE("vertex setup");
+        // Do processing.
+        // Give the uniform var "ourValue" its value.
+        float tv1 = context->GetTime();
+        float r1 = (sin(tv1) / 2.0f) + 0.5f;
+        float g1 = (cos(tv1) / 2.0f) + 0.5f;
+        float b1 = (sin(tv1 * 2) / 2.0f) + 0.5f;
+        float tv2 = context->GetTime();
+        float r2 = (cos(tv2) / 2.0f) + 0.5f;
+        float g2 = (sin(tv2) / 2.0f) + 0.5f;
+        float b2 = (cos(tv2 * 2) / 2.0f) + 0.5f;
+
+        // Animated colors are written straight into this frame's region of
+        // the vertex ring; the VAO set up above already points at it.
+        stream->NextFrame();
+        Vertex* vertices = static_cast<Vertex*>(stream->Begin(3));
+        if (vertices == nullptr)
+        {
+          return -1;
+        }
         // positions          // colors
-        -0.75f, 0.75f, 0.0f, r1, g1, b1,
-        0.0f, -0.75f, 0.0f,   0.0f, 0.0f, 0.0f,
-        0.75f, 0.75f, 0.0f,  r2, g2, b2,
-      };
-      // Bind VAO.
-      unsigned int VAO[1];
-      glGenVertexArrays(1, VAO);
-      // Buffer type of a vertex buffer is GL_ARRAY_BUFFER.
-      // Bind newly created buffer to the GL_ARRAY_BUFFER target.
-      unsigned int VBO[1];
-      glGenBuffers(1, VBO);
-
-      // First triangle setup.
-      glBindVertexArray(VAO[0]);
-      glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
-      // Copy vertices[] to buffer's memory using glBufferData.
-      // glBufferDtata is a function used to copy user-defined data into the "currently bound" buffer.
-      glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-      glVertexAttribPointer(/* attribute location = 0 */ 0, /* size of attribute */ 3,
-                            GL_FLOAT, /*data to be normalized?*/ GL_FALSE,
-                            /* stride or space b/w consecutive vertex attributes*/ 6 * sizeof(float),
-                            /* offset where position begins in the buffer */ (void*)0);
-      glEnableVertexAttribArray(0);
-      glVertexAttribPointer(/* attribute location = 1 */ 1, /* size of attribute */ 3,
-                            GL_FLOAT, /*data to be normalized?*/ GL_FALSE,
-                            /* stride or space b/w consecutive vertex attributes*/ 6 * sizeof(float),
-                            /* offset where position begins in the buffer */ (void*)(3* sizeof(float)));
-      glEnableVertexAttribArray(1);
+        vertices[0] = {{-0.75f, 0.75f, 0.0f}, {r1, g1, b1}};
+        vertices[1] = {{0.0f, -0.75f, 0.0f},  {0.0f, 0.0f, 0.0f}};
+        vertices[2] = {{0.75f, 0.75f, 0.0f},  {r2, g2, b2}};
+        if (!stream->End(&first))
+        {
+          return -1;
+        }
+      }
       // Rendering commands here.
       glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
       glClear(GL_COLOR_BUFFER_BIT);
-      shader->setFloat("rightShiftOffset", 0.25f);
-      shader->use();
-      glBindVertexArray(VAO[0]);
-      glDrawArrays(GL_TRIANGLES, 0, 3);
+      {
+        TRACE_SCOPE("draw submission");
+        shader->use();
+        GlState::BindVertexArray(stream->vertex_array());
+        glDrawArrays(GL_TRIANGLES, first, 3);
+      }
       // glDrawArrays(GL_TRIANGLES, 0, 3);
-      // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+      // swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
       // -------------------------------------------------------------------------------
-      glfwSwapBuffers(window);
-      glfwPollEvents();
+      context->SwapBuffers();
+      context->PollEvents();
     }
 
-    // glfw: terminate, clearing all previously allocated GLFW resources.
-    // ------------------------------------------------------------------
-    glfwTerminate();
+    std::cout << "vertex ring persistent: " << stream->ring().persistent()
+              << ", stalls: " << stream->ring().stalls() << std::endl;
+    // The context terminates GLFW (or tears down EGL) when it goes out of scope.
     return 0;
 }
 
-// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// process all input: query the context whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
-void processInput(GLFWwindow *window)
-{
-    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-        glfwSetWindowShouldClose(window, true);
-}
-
-// glfw: whenever the window size changed (by OS or user resize) this callback function executes
-// ---------------------------------------------------------------------------------------------
-void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+void processInput(Context *context)
 {
-    // make sure the viewport matches the new window dimensions; note that width and
-    // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
+    if(context->IsKeyPressed(GLFW_KEY_ESCAPE))
+        context->SetShouldClose();
 }
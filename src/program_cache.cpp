@@ -0,0 +1,186 @@
+#include "program_cache.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "gl_ext.h"
+#include "hash.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace experimentgl {
+
+namespace {
+
+// "XGPB" in little-endian; bump kVersion when the layout changes.
+const uint32_t kMagic = 0x42504758;
+const uint32_t kVersion = 2;
+
+// Seeds the check hash, so it does not collide where the file name does.
+const uint64_t kCheckSeed = 0x9e3779b97f4a7c15ull;
+
+struct Header {
+  uint32_t magic;
+  uint32_t version;
+  // Everything of the key but the hash already in the file name.
+  uint64_t check;
+  uint32_t vertex_length;
+  uint32_t fragment_length;
+  uint32_t binary_format;
+  uint32_t length;
+};
+
+std::string cache_directory;
+bool cache_enabled = false;
+
+std::string entry_path(uint64_t key) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+  return cache_directory + "/" + name;
+}
+
+std::string gl_string(GLenum name) {
+  const GLubyte* s = glGetString(name);
+  return s != nullptr ? reinterpret_cast<const char*>(s) : "";
+}
+
+} // anonymous namespace.
+
+void ProgramCache::Enable(const std::string& directory) {
+  cache_enabled = false;
+  if (gl_ext().GetProgramBinary == nullptr || gl_ext().ProgramBinary == nullptr) {
+    std::cout << "Program binaries unsupported, shader cache disabled" << std::endl;
+    return;
+  }
+  GLint formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  if (formats == 0) {
+    std::cout << "Driver has no program binary formats, shader cache disabled" << std::endl;
+    return;
+  }
+  if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+    std::cout << "Could not create shader cache " << directory << std::endl;
+    return;
+  }
+  cache_directory = directory;
+  cache_enabled = true;
+}
+
+bool ProgramCache::enabled() {
+  return cache_enabled;
+}
+
+ProgramCacheKey ProgramCache::Key(const std::string& vertex_source,
+                                  const std::string& fragment_source) {
+  // The lengths keep "ab" + "c" apart from "a" + "bc".
+  std::string sizes = std::to_string(vertex_source.size()) + ":" +
+                      std::to_string(fragment_source.size());
+  std::string driver = gl_string(GL_VENDOR) + "\n" + gl_string(GL_RENDERER) + "\n" +
+                       gl_string(GL_VERSION);
+  ProgramCacheKey key;
+  key.hash = Fnv1a64(sizes);
+  key.hash = Fnv1a64(vertex_source, key.hash);
+  key.hash = Fnv1a64(fragment_source, key.hash);
+  key.hash = Fnv1a64(driver, key.hash);
+  // Another seed and order, so inputs colliding in 'hash' still differ here.
+  key.check = Fnv1a64(driver, kCheckSeed);
+  key.check = Fnv1a64(fragment_source, key.check);
+  key.check = Fnv1a64(vertex_source, key.check);
+  key.vertex_length = static_cast<uint32_t>(vertex_source.size());
+  key.fragment_length = static_cast<uint32_t>(fragment_source.size());
+  return key;
+}
+
+bool ProgramCache::Load(const ProgramCacheKey& key, GLuint program) {
+  if (!cache_enabled) {
+    return false;
+  }
+  std::string path = entry_path(key.hash);
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  struct stat file;
+  if (stat(path.c_str(), &file) != 0) {
+    return false;
+  }
+  Header header;
+  std::vector<char> binary;
+  if (in.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+      header.magic == kMagic && header.version == kVersion) {
+    if (header.check != key.check || header.vertex_length != key.vertex_length ||
+        header.fragment_length != key.fragment_length) {
+      // Other sources whose hash collides with these: a miss, and the
+      // relinked program replaces their entry.
+      return false;
+    }
+    // The length comes from disk: trust it only if the file really holds
+    // that many bytes, so a torn entry is discarded rather than allocated.
+    if (static_cast<off_t>(sizeof(header)) + header.length == file.st_size) {
+      binary.resize(header.length);
+      in.read(binary.data(), binary.size());
+    }
+  }
+  in.close();
+  if (binary.empty() || in.fail()) {
+    std::cout << "Discarding corrupt shader cache entry " << path << std::endl;
+    std::remove(path.c_str());
+    return false;
+  }
+  gl_ext().ProgramBinary(program, header.binary_format, binary.data(), binary.size());
+  GLint success = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  if (!success) {
+    // Drivers may reject binaries of another build even with equal strings.
+    std::cout << "Driver rejected shader cache entry " << path << std::endl;
+    std::remove(path.c_str());
+    return false;
+  }
+  return true;
+}
+
+void ProgramCache::Store(const ProgramCacheKey& key, GLuint program) {
+  if (!cache_enabled) {
+    return;
+  }
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return;
+  }
+  std::vector<char> binary(length);
+  GLenum format = 0;
+  gl_ext().GetProgramBinary(program, length, &length, &format, binary.data());
+  Header header = {kMagic, kVersion, key.check, key.vertex_length, key.fragment_length, format,
+                   static_cast<uint32_t>(length)};
+  // Write to a temporary name of this process's own and rename, so a crash
+  // or a concurrent run never leaves a half-written entry behind.
+  std::string path = entry_path(key.hash);
+  std::string tmp_path = path + "." + std::to_string(getpid()) + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(binary.data(), length);
+    if (!out) {
+      std::cout << "Could not write shader cache entry " << tmp_path << std::endl;
+      std::remove(tmp_path.c_str());
+      return;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+  }
+}
+
+void ProgramCache::PrepareLink(GLuint program) {
+  if (cache_enabled) {
+    gl_ext().ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+}
+
+}
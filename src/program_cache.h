@@ -0,0 +1,49 @@
+#ifndef PROGRAM_CACHE_H_
+#define PROGRAM_CACHE_H_
+
+#include <glad/glad.h>  // include glad to get all the required OpenGL headers
+
+#include <cstdint>
+#include <string>
+
+namespace experimentgl {
+
+// Identifies a program's sources on the current driver. 'hash' names the
+// cache file; the rest is stored in the entry and compared on load, so
+// sources whose hashes collide never share a binary.
+struct ProgramCacheKey {
+  uint64_t hash = 0;
+  // A second, differently seeded hash, and the source lengths.
+  uint64_t check = 0;
+  uint32_t vertex_length = 0;
+  uint32_t fragment_length = 0;
+};
+
+// On-disk cache of linked program binaries (glGetProgramBinary), one file per
+// program under a cache directory. Entries are keyed by a hash of the shader
+// sources and the driver's vendor, renderer and version strings, so editing a
+// shader or updating the driver simply misses and relinks. Binaries the driver
+// rejects anyway are deleted and rebuilt by the caller.
+//
+// Disabled until Enable() is called, and when the context cannot return
+// program binaries.
+class ProgramCache {
+ public:
+  // Caches under 'directory', creating it if needed. Call after LoadGlExt().
+  static void Enable(const std::string& directory);
+  static bool enabled();
+  // Key for a program linked from these sources on the current driver.
+  static ProgramCacheKey Key(const std::string& vertex_source, const std::string& fragment_source);
+  // Loads the binary stored under 'key' into 'program'. Returns true only if
+  // the driver accepted it and the program is linked.
+  static bool Load(const ProgramCacheKey& key, GLuint program);
+  // Writes the binary of the linked 'program' under 'key'. The program must
+  // have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set, see
+  // PrepareLink().
+  static void Store(const ProgramCacheKey& key, GLuint program);
+  // Call before glLinkProgram() on programs that will be stored.
+  static void PrepareLink(GLuint program);
+};
+
+}
+#endif // PROGRAM_CACHE_H_
@@ -0,0 +1,134 @@
+#include "program_reflection.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace experimentgl {
+
+namespace {
+
+// Arrays are reported as "name[0]"; callers ask for "name".
+std::string strip_array(const char* name, GLsizei length) {
+  std::string stripped(name, length);
+  if (stripped.size() > 3 && stripped.compare(stripped.size() - 3, 3, "[0]") == 0) {
+    stripped.resize(stripped.size() - 3);
+  }
+  return stripped;
+}
+
+template <typename Entry>
+bool by_name(const Entry& a, const Entry& b) {
+  return a.name < b.name;
+}
+
+// Binary search of a table sorted with by_name().
+template <typename Entry>
+const Entry* find(const std::vector<Entry>& table, const std::string& name) {
+  auto it = std::lower_bound(table.begin(), table.end(), name,
+                             [](const Entry& entry, const std::string& key) {
+                               return entry.name < key;
+                             });
+  return it != table.end() && it->name == name ? &*it : nullptr;
+}
+
+} // anonymous namespace.
+
+ProgramReflection ProgramReflection::Reflect(GLuint program) {
+  ProgramReflection reflection;
+  GLint max_length = 0;
+  std::vector<char> name;
+
+  // Blocks first, so uniforms can refer to their sorted position.
+  GLint count = 0;
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &max_length);
+  name.resize(std::max(max_length, 1));
+  for (GLint i = 0; i < count; ++i) {
+    GLsizei length = 0;
+    glGetActiveUniformBlockName(program, i, name.size(), &length, name.data());
+    ReflectedBlock block{std::string(name.data(), length), static_cast<GLuint>(i), 0, 0};
+    glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_DATA_SIZE, &block.data_size);
+    glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_BINDING, &block.binding);
+    reflection.blocks_.push_back(block);
+  }
+  std::sort(reflection.blocks_.begin(), reflection.blocks_.end(), by_name<ReflectedBlock>);
+  // Block index in the program -> position in blocks_.
+  std::vector<GLint> block_position(count);
+  for (size_t i = 0; i < reflection.blocks_.size(); ++i) {
+    block_position[reflection.blocks_[i].index] = i;
+  }
+
+  glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+  name.resize(std::max(max_length, 1));
+  if (count > 0) {
+    // One query per property for all uniforms at once.
+    std::vector<GLuint> indices(count);
+    for (GLint i = 0; i < count; ++i) {
+      indices[i] = i;
+    }
+    std::vector<GLint> types(count), sizes(count), blocks(count), offsets(count), strides(count);
+    glGetActiveUniformsiv(program, count, indices.data(), GL_UNIFORM_TYPE, types.data());
+    glGetActiveUniformsiv(program, count, indices.data(), GL_UNIFORM_SIZE, sizes.data());
+    glGetActiveUniformsiv(program, count, indices.data(), GL_UNIFORM_BLOCK_INDEX, blocks.data());
+    glGetActiveUniformsiv(program, count, indices.data(), GL_UNIFORM_OFFSET, offsets.data());
+    glGetActiveUniformsiv(program, count, indices.data(), GL_UNIFORM_ARRAY_STRIDE, strides.data());
+    for (GLint i = 0; i < count; ++i) {
+      GLsizei length = 0;
+      glGetActiveUniformName(program, i, name.size(), &length, name.data());
+      ReflectedUniform uniform{strip_array(name.data(), length), static_cast<GLenum>(types[i]),
+                               sizes[i], -1, -1, offsets[i], strides[i]};
+      if (blocks[i] >= 0) {
+        uniform.block = block_position[blocks[i]];
+      } else {
+        uniform.location = glGetUniformLocation(program, name.data());
+      }
+      reflection.uniforms_.push_back(uniform);
+    }
+    std::sort(reflection.uniforms_.begin(), reflection.uniforms_.end(),
+              by_name<ReflectedUniform>);
+  }
+
+  glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+  glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &max_length);
+  name.resize(std::max(max_length, 1));
+  for (GLint i = 0; i < count; ++i) {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveAttrib(program, i, name.size(), &length, &size, &type, name.data());
+    // Built-ins like gl_VertexID are active but have no location.
+    GLint location = glGetAttribLocation(program, name.data());
+    if (location < 0) {
+      continue;
+    }
+    reflection.attributes_.push_back(
+        ReflectedAttribute{strip_array(name.data(), length), type, size, location});
+  }
+  std::sort(reflection.attributes_.begin(), reflection.attributes_.end(),
+            by_name<ReflectedAttribute>);
+  return reflection;
+}
+
+const ReflectedUniform* ProgramReflection::FindUniform(const std::string& name) const {
+  return find(uniforms_, name);
+}
+
+const ReflectedAttribute* ProgramReflection::FindAttribute(const std::string& name) const {
+  return find(attributes_, name);
+}
+
+const ReflectedBlock* ProgramReflection::FindBlock(const std::string& name) const {
+  return find(blocks_, name);
+}
+
+void ProgramReflection::SetBlockBinding(GLuint index, GLint binding) {
+  for (ReflectedBlock& block : blocks_) {
+    if (block.index == index) {
+      block.binding = binding;
+    }
+  }
+}
+
+}
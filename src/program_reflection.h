@@ -0,0 +1,73 @@
+#ifndef PROGRAM_REFLECTION_H_
+#define PROGRAM_REFLECTION_H_
+
+#include <glad/glad.h>  // include glad to get all the required OpenGL headers
+
+#include <string>
+#include <vector>
+
+namespace experimentgl {
+
+// An active uniform, either a plain one with a location or a member of a
+// uniform block with an offset into it.
+struct ReflectedUniform {
+  // As GL reports it, minus the "[0]" of arrays. Block members are
+  // "Block.member" when the block has an instance name, "member" otherwise.
+  std::string name;
+  GLenum type;
+  // Array length, 1 for non-arrays.
+  GLint size;
+  // -1 for block members.
+  GLint location;
+  // Index into ProgramReflection::blocks(), or -1.
+  GLint block;
+  // Byte offset and array stride in the block, -1 outside blocks.
+  GLint offset;
+  GLint array_stride;
+};
+
+struct ReflectedAttribute {
+  std::string name;
+  GLenum type;
+  GLint size;
+  GLint location;
+};
+
+struct ReflectedBlock {
+  std::string name;
+  // Block index in the program.
+  GLuint index;
+  // Minimum size of the buffer range bound to it.
+  GLint data_size;
+  GLint binding;
+};
+
+// Everything a linked program can tell about its interface, queried once
+// at link time and kept in flat tables sorted by name, so lookups in the
+// frame loop are binary searches rather than GL queries.
+class ProgramReflection {
+ public:
+  ProgramReflection() = default;
+  // Queries the active uniforms, attributes and uniform blocks of 'program',
+  // which must have linked.
+  static ProgramReflection Reflect(GLuint program);
+
+  const std::vector<ReflectedUniform>& uniforms() const { return uniforms_; }
+  const std::vector<ReflectedAttribute>& attributes() const { return attributes_; }
+  const std::vector<ReflectedBlock>& blocks() const { return blocks_; }
+  // nullptr if there is no such active uniform, attribute or block.
+  const ReflectedUniform* FindUniform(const std::string& name) const;
+  const ReflectedAttribute* FindAttribute(const std::string& name) const;
+  const ReflectedBlock* FindBlock(const std::string& name) const;
+  // Records a glUniformBlockBinding() made on the program.
+  void SetBlockBinding(GLuint index, GLint binding);
+
+ private:
+  std::vector<ReflectedUniform> uniforms_;
+  std::vector<ReflectedAttribute> attributes_;
+  // Sorted by name too; ReflectedUniform::block indexes this vector.
+  std::vector<ReflectedBlock> blocks_;
+};
+
+}
+#endif // PROGRAM_REFLECTION_H_
@@ -1,10 +1,22 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "context.h"
+#include "gl_resources.h"
+#include "gl_state.h"
+#include "trace.h"
+
 #include <iostream>
 
-void framebuffer_size_callback(GLFWwindow* window, int width, int height);
-void processInput(GLFWwindow *window);
+using experimentgl::Context;
+using experimentgl::ContextOptions;
+using experimentgl::GlBuffer;
+using experimentgl::GlProgram;
+using experimentgl::GlState;
+using experimentgl::GlVertexArray;
+using experimentgl::ParseContextOptions;
+
+void processInput(Context *context);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
@@ -61,32 +73,17 @@ unsigned int compileFragmentShader() {
   return frag_shader;
 }
 
-int main()
+int main(int argc, char** argv)
 {
-    // glfw: initialize and configure
-    // ------------------------------
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    // glfw window creation
-    // --------------------
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Experiments", NULL, NULL);
-    if (window == NULL)
+    // Create the GL context: a GLFW window, or an offscreen FBO with --headless.
+    // --------------------------------------------------------------------------
+    ContextOptions options;
+    options.width = SCR_WIDTH;
+    options.height = SCR_HEIGHT;
+    options.title = "Experiments";
+    std::unique_ptr<Context> context = Context::Create(ParseContextOptions(argc, argv, options));
+    if (context == nullptr)
     {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
-    // glad: load all OpenGL function pointers
-    // ---------------------------------------
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-    {
-        std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
 
@@ -96,19 +93,18 @@ int main()
       0.25f, -0.25f, 0.0f,
     };
     // Bind VAO.
-    unsigned int VAO[1];
-    glGenVertexArrays(1, VAO);
+    GlVertexArray VAO = GlVertexArray::Create();
     // Buffer type of a vertex buffer is GL_ARRAY_BUFFER.
     // Bind newly created buffer to the GL_ARRAY_BUFFER target.
-    unsigned int VBO[1];
-    glGenBuffers(1, VBO);
+    GlBuffer VBO = GlBuffer::Create();
 
     // First triangle setup.
-    glBindVertexArray(VAO[0]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
+    GlState::BindVertexArray(VAO.get());
+    GlState::BindBuffer(GL_ARRAY_BUFFER, VBO.get());
     // Copy vertices[] to buffer's memory using glBufferData.
     // glBufferDtata is a function used to copy user-defined data into the "currently bound" buffer.
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    VBO.SetBytes(sizeof(vertices));
     glVertexAttribPointer(/* attribute location = 0 */ 0, /* size of attribute */ 3,
                           GL_FLOAT, /*data to be normalized?*/ GL_FALSE,
                           /* stride or space b/w consecutive vertex attributes*/ 3 * sizeof(float),
@@ -120,63 +116,58 @@ int main()
     unsigned int fs = compileFragmentShader();
     // Shader program: multiple shaders combined.
     // Links output of each shader to the input of the next shader.
-    unsigned int sp = glCreateProgram();
-    glAttachShader(sp, vs);
-    glAttachShader(sp, fs);
-    glLinkProgram(sp);
+    GlProgram sp = GlProgram::Create();
+    glAttachShader(sp.get(), vs);
+    glAttachShader(sp.get(), fs);
+    glLinkProgram(sp.get());
     // Check if linking was successful.
     int success;
     char msg[512];
-    glGetShaderiv(sp, GL_LINK_STATUS, &success);
+    glGetShaderiv(sp.get(), GL_LINK_STATUS, &success);
     if (!success) {
-      glGetShaderInfoLog(sp, 512, NULL, msg);
+      glGetShaderInfoLog(sp.get(), 512, NULL, msg);
       std::cout << "SHADER LINK FAILED\n" << msg << std::endl;
     }
-    glUseProgram(sp);
     // Once linked we do not need them anymore.
     glDeleteShader(vs);
     glDeleteShader(fs);
 
     // render loop
     // -----------
-    while (!glfwWindowShouldClose(window))
+    while (!context->ShouldClose())
     {
         // input
         // -----
-        processInput(window);
+        {
+            TRACE_SCOPE("processInput");
+            processInput(context.get());
+        }
 
         // Rendering commands here.
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
-        glUseProgram(sp);
-        glBindVertexArray(VAO[0]);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
+        {
+            TRACE_SCOPE("draw submission");
+            GlState::UseProgram(sp.get());
+            GlState::BindVertexArray(VAO.get());
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
         // glDrawArrays(GL_TRIANGLES, 0, 3);
-        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        context->SwapBuffers();
+        context->PollEvents();
     }
 
-    // glfw: terminate, clearing all previously allocated GLFW resources.
-    // ------------------------------------------------------------------
-    glfwTerminate();
+    // The handles above delete their objects before the context goes away.
+    // The context terminates GLFW (or tears down EGL) when it goes out of scope.
     return 0;
 }
 
-// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// process all input: query the context whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
-void processInput(GLFWwindow *window)
-{
-    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-        glfwSetWindowShouldClose(window, true);
-}
-
-// glfw: whenever the window size changed (by OS or user resize) this callback function executes
-// ---------------------------------------------------------------------------------------------
-void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+void processInput(Context *context)
 {
-    // make sure the viewport matches the new window dimensions; note that width and
-    // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
+    if(context->IsKeyPressed(GLFW_KEY_ESCAPE))
+        context->SetShouldClose();
 }
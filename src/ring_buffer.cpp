@@ -0,0 +1,114 @@
+#include "ring_buffer.h"
+
+#include "gl_ext.h"
+#include "gl_state.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace experimentgl {
+
+namespace {
+
+// Wait for a fence in steps of this long, and give up after kMaxFenceWaits
+// steps, so a lost context or hung GPU cannot hang us.
+const GLuint64 kFenceTimeoutNs = 1000000000;
+const int kMaxFenceWaits = 5;
+
+} // anonymous namespace.
+
+std::unique_ptr<RingBuffer> RingBuffer::Create(GLenum target, GLsizeiptr region_size) {
+  GLsizeiptr size = region_size * kRegions;
+  GlBuffer buffer = GlBuffer::Create();
+  GlState::BindBuffer(target, buffer.get());
+  char* mapped = nullptr;
+  if (gl_ext().BufferStorage != nullptr) {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    gl_ext().BufferStorage(target, size, NULL, flags);
+    mapped = static_cast<char*>(glMapBufferRange(target, 0, size, flags));
+    if (mapped == nullptr) {
+      std::cout << "Could not map a " << size << " byte ring buffer" << std::endl;
+      return nullptr;
+    }
+  } else {
+    glBufferData(target, size, NULL, GL_STREAM_DRAW);
+  }
+  buffer.SetBytes(size);
+  return std::unique_ptr<RingBuffer>(
+      new RingBuffer(target, std::move(buffer), region_size, mapped));
+}
+
+RingBuffer::~RingBuffer() {
+  for (GLsync fence : fences_) {
+    if (fence != nullptr) {
+      glDeleteSync(fence);
+    }
+  }
+  if (mapped_ != nullptr) {
+    GlState::BindBuffer(target_, buffer_.get());
+    glUnmapBuffer(target_);
+  }
+}
+
+void RingBuffer::NextFrame() {
+  if (fences_[region_] != nullptr) {
+    glDeleteSync(fences_[region_]);
+  }
+  fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  region_ = (region_ + 1) % kRegions;
+  head_ = region_ * region_size_;
+  GLsync fence = fences_[region_];
+  if (fence == nullptr) {
+    return;
+  }
+  // Usually signaled long ago; only wait if the GPU is a whole ring behind.
+  GLenum result = glClientWaitSync(fence, 0, 0);
+  if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+    ++stalls_;
+    for (int waits = 0; waits < kMaxFenceWaits; ++waits) {
+      result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeoutNs);
+      if (result != GL_TIMEOUT_EXPIRED) {
+        break;
+      }
+    }
+    if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+      std::cout << "Ring buffer region " << region_ << " still in use by the GPU after "
+                << kMaxFenceWaits << " s, overwriting it" << std::endl;
+    }
+  }
+  glDeleteSync(fence);
+  fences_[region_] = nullptr;
+}
+
+bool RingBuffer::Reserve(GLsizeiptr size, GLsizeiptr alignment, GLintptr* offset) {
+  GLintptr start = (head_ + alignment - 1) / alignment * alignment;
+  if (start + size > (region_ + 1) * region_size_) {
+    return false;
+  }
+  *offset = start;
+  head_ = start + size;
+  return true;
+}
+
+bool RingBuffer::Write(const void* data, GLsizeiptr size, GLsizeiptr alignment,
+                       GLintptr* offset) {
+  if (!Reserve(size, alignment, offset)) {
+    return false;
+  }
+  if (mapped_ != nullptr) {
+    std::memcpy(mapped_ + *offset, data, size);
+  } else {
+    GlState::BindBuffer(target_, buffer_.get());
+    glBufferSubData(target_, *offset, size, data);
+  }
+  return true;
+}
+
+void* RingBuffer::Allocate(GLsizeiptr size, GLsizeiptr alignment, GLintptr* offset) {
+  if (mapped_ == nullptr || !Reserve(size, alignment, offset)) {
+    return nullptr;
+  }
+  return mapped_ + *offset;
+}
+
+}
@@ -0,0 +1,74 @@
+#ifndef RING_BUFFER_H_
+#define RING_BUFFER_H_
+
+#include <glad/glad.h>  // include glad to get all the required OpenGL headers
+
+#include "gl_resources.h"
+
+#include <memory>
+#include <utility>
+
+namespace experimentgl {
+
+// A GL buffer the CPU streams per-frame data into, split into one region per
+// frame in flight. Each region is written front to back during its frame
+// and fenced when the frame is over; it is only reused once that fence
+// signals, so the GPU is never waited on unless it falls a whole ring behind.
+//
+// With ARB_buffer_storage the buffer stays persistently and coherently
+// mapped and writes are plain memcpys. Without it every write is a
+// glBufferSubData at the same offsets.
+class RingBuffer {
+ public:
+  // Frames the CPU may run ahead of the GPU.
+  static const int kRegions = 3;
+
+  // Creates a ring for 'target' data with room for 'region_size' bytes per
+  // frame. Returns nullptr if the storage cannot be mapped.
+  static std::unique_ptr<RingBuffer> Create(GLenum target, GLsizeiptr region_size);
+  ~RingBuffer();
+
+  // Moves on to the next region. Call once per frame before its first
+  // Write(): it fences everything written since the previous call. Waits
+  // for the GPU to release the region, but gives up after a few seconds,
+  // reports it, and reuses the region anyway.
+  void NextFrame();
+  // Copies 'size' bytes into the current region at the next multiple of
+  // 'alignment' and stores where in the buffer they went in 'offset'.
+  // Returns false, writing nothing, if the region is full.
+  bool Write(const void* data, GLsizeiptr size, GLsizeiptr alignment, GLintptr* offset);
+  // Room for the data about to be written: a pointer to 'size' bytes at the
+  // next multiple of 'alignment', which stays valid for this frame. nullptr
+  // if the region is full or the ring is not mapped; use Write() then.
+  void* Allocate(GLsizeiptr size, GLsizeiptr alignment, GLintptr* offset);
+
+  GLuint buffer() const { return buffer_.get(); }
+  bool persistent() const { return mapped_ != nullptr; }
+  GLsizeiptr region_size() const { return region_size_; }
+  // Bytes written to the current region so far.
+  GLsizeiptr used() const { return head_ - region_ * region_size_; }
+  // NextFrame() calls that had to wait for the GPU.
+  long stalls() const { return stalls_; }
+
+ private:
+  RingBuffer(GLenum target, GlBuffer buffer, GLsizeiptr region_size, char* mapped)
+      : target_(target), buffer_(std::move(buffer)), region_size_(region_size), mapped_(mapped) {}
+  // Moves 'head_' to the next multiple of 'alignment' with room for 'size'
+  // bytes in the current region. Returns false if there is none.
+  bool Reserve(GLsizeiptr size, GLsizeiptr alignment, GLintptr* offset);
+
+  GLenum target_;
+  GlBuffer buffer_;
+  GLsizeiptr region_size_;
+  // Start of the mapped buffer, or nullptr without buffer storage.
+  char* mapped_;
+  // Region being written and the next free byte in the buffer.
+  int region_ = 0;
+  GLintptr head_ = 0;
+  // Signals once the GPU is done with the frame that wrote each region.
+  GLsync fences_[kRegions] = {};
+  long stalls_ = 0;
+};
+
+}
+#endif // RING_BUFFER_H_
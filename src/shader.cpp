@@ -1,117 +1,361 @@
 #include "shader.h"
-#include <fstream>
+
+#include "gl_ext.h"
+#include "gl_state.h"
+#include "program_cache.h"
+#include "program_reflection.h"
+#include "shader_reloader.h"
+
+#include <cstdint>
+#include <iterator>
 #include <memory>
-#include <sstream>
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <iostream>
 
 namespace experimentgl {
 
 namespace {
 
-std::string load_file(const std::string& path) {
-  std::ifstream shader(path);
-  std::stringstream ss;
-  ss << shader.rdbuf();
-  shader.close();
-  return ss.str();
+// The UniformShadow of each live program. Shaders sharing a program share
+// its uniform values, so they must share the shadow too.
+std::unordered_map<const GlObject*, std::weak_ptr<UniformShadow>> shadows;
+
+std::shared_ptr<UniformShadow> shadow_for(const ProgramHandle& program,
+                                          const ProgramReflection& reflection) {
+  std::weak_ptr<UniformShadow>& entry = shadows[program.get()];
+  std::shared_ptr<UniformShadow> shadow = entry.lock();
+  if (shadow == nullptr) {
+    shadow = std::make_shared<UniformShadow>(reflection);
+    entry = shadow;
+  }
+  // Drop entries of programs no Shader holds anymore.
+  for (auto it = shadows.begin(); it != shadows.end();) {
+    it = it->second.expired() ? shadows.erase(it) : std::next(it);
+  }
+  return shadow;
 }
 
 } // anonymous namespace.
 
-Shader::Shader(std::string v_path, std::string fr_path): v_path_(v_path), fr_path_(fr_path){}
+Shader::Shader(std::string v_path, std::string fr_path, ShaderDefines defines,
+               UniformConstants constants)
+    : id_(0), v_path_(v_path), fr_path_(fr_path), defines_(std::move(defines)),
+      constants_(std::move(constants)){}
 
-std::unique_ptr<Shader> Shader::Create(std::string v_path, std::string fr_path) {
-  std::unique_ptr<Shader> s (new Shader(v_path, fr_path));
-  if (!s->Init()) {
+Shader::~Shader() {
+  ShaderReloader::Unwatch(this);
+}
+
+std::unique_ptr<Shader> Shader::Create(std::string v_path, std::string fr_path,
+                                       const ShaderDefines& defines) {
+  std::unique_ptr<Shader> s (new Shader(v_path, fr_path, defines));
+  if (!s->Submit() || !s->Finish()) {
     std::cout << "Could not initialize shaders!";
     return nullptr;
   }
+  ShaderReloader::Watch(s.get());
   return s;
 }
 
-unsigned int Shader::CompileShader(unsigned int shader_type, const char* source) {
-  unsigned int shader;
+ShaderFuture Shader::CreateAsync(std::string v_path, std::string fr_path,
+                                 const ShaderDefines& defines) {
+  std::unique_ptr<Shader> s (new Shader(v_path, fr_path, defines));
+  if (!s->Submit()) {
+    std::cout << "Could not initialize shaders!";
+    return ShaderFuture();
+  }
+  return ShaderFuture(std::move(s));
+}
+
+bool Shader::CheckShader(unsigned int shader, const GlslSource& source) {
   int success;
   char info_log[512];
-
-  switch (shader_type) {
-    case GL_VERTEX_SHADER:
-      // vertex shader.
-      shader = glCreateShader(GL_VERTEX_SHADER);
-      break;
-    case GL_FRAGMENT_SHADER:
-      // fragment shader.
-      shader = glCreateShader(GL_FRAGMENT_SHADER);
-      break;
-    default:
-      std::cout << "Invalid shader type given";
-      // TODO(kirtivr): use StatusOr once I figure out CMake.
-      return 0;
-  }
-  glShaderSource(shader, 1, &source, NULL);
-  glCompileShader(shader);
   // print compile errors, if any.
   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
   if (!success) {
     glGetShaderInfoLog(shader, 512, NULL, info_log);
     std::cout << "shader compile failed: " << info_log << std::endl;
+    for (size_t i = 0; i < source.files.size(); ++i) {
+      std::cout << "  " << i << ": " << source.files[i] << std::endl;
+    }
   }
-  return shader;
+  return success;
 }
 
-bool Shader::CompileProgram(unsigned int vertex, unsigned int fragment) {
+unsigned int Shader::CompileProgram(unsigned int vertex, unsigned int fragment) {
   // Shader program.
-  id_ = glCreateProgram();
-  glAttachShader(id_, vertex);
-  glAttachShader(id_, fragment);
-  glLinkProgram(id_);
+  unsigned int program = glCreateProgram();
+  glAttachShader(program, vertex);
+  glAttachShader(program, fragment);
+  ProgramCache::PrepareLink(program);
+  glLinkProgram(program);
+  return program;
+}
+
+void Shader::LoadUniformLocations() {
+  // Reset in place rather than clear(): Uniform<T> handles point at entries.
+  for (auto& entry : uniform_locations_) {
+    entry.second = -1;
+  }
+  size_t count = 0;
+  for (const ReflectedUniform& uniform : reflection_.uniforms()) {
+    // Uniforms inside blocks have no location. Names come from reflection,
+    // which strips only a trailing "[0]": "weights[0]" is stored as
+    // "weights", while "lights[0].color" and "lights[1].color" keep their
+    // indices and locations.
+    if (uniform.location >= 0) {
+      uniform_locations_[uniform.name] = uniform.location;
+      ++count;
+    }
+  }
+  size_t size = 1;
+  while (size < 2 * count) {
+    size *= 2;
+  }
+  location_table_.assign(size, LocationSlot{0, -1});
+  for (const ReflectedUniform& uniform : reflection_.uniforms()) {
+    if (uniform.location < 0) {
+      continue;
+    }
+    UniformId id = Fnv1a64(uniform.name);
+    size_t slot = id & (size - 1);
+    while (location_table_[slot].id != 0) {
+      if (location_table_[slot].id == id) {
+        std::cout << "Uniform " << uniform.name << " collides with another name's id" << std::endl;
+      }
+      slot = (slot + 1) & (size - 1);
+    }
+    location_table_[slot] = LocationSlot{id, uniform.location};
+  }
+}
+
+GLint Shader::FindLocation(UniformId id) const {
+  size_t mask = location_table_.size() - 1;
+  for (size_t slot = id & mask; !location_table_.empty(); slot = (slot + 1) & mask) {
+    if (location_table_[slot].id == id) {
+      return location_table_[slot].location;
+    }
+    if (location_table_[slot].id == 0) {
+      return -1;
+    }
+  }
+  return -1;
+}
+
+bool Shader::Submit() {
+  Discard();
+  if (!PreprocessGlsl(v_path_, defines_, &build_.vertex_source) ||
+      !PreprocessGlsl(fr_path_, defines_, &build_.fragment_source)) {
+    return false;
+  }
+  if (!constants_.empty()) {
+    std::set<std::string> baked;
+    BakeUniforms(constants_, &build_.vertex_source, &baked);
+    BakeUniforms(constants_, &build_.fragment_source, &baked);
+    for (const auto& constant : constants_.values()) {
+      if (baked.count(constant.first) == 0) {
+        std::cout << "No uniform declaration of " << constant.first << " to specialize" << std::endl;
+      }
+    }
+  }
+  const std::string& v_code = build_.vertex_source.text;
+  const std::string& fr_code = build_.fragment_source.text;
+  std::cout<< "vertex shader: " << v_code << std::endl;
+  std::cout<< "fragment shader: " << fr_code << std::endl;
+  building_ = true;
+  build_.program = ShaderRegistry::FindProgram(v_code, fr_code);
+  if (build_.program != nullptr) {
+    return true;
+  }
+  if (ProgramCache::enabled()) {
+    build_.cache_key = ProgramCache::Key(v_code, fr_code);
+    unsigned int program = glCreateProgram();
+    if (ProgramCache::Load(build_.cache_key, program)) {
+      build_.program = ShaderRegistry::AddProgram(v_code, fr_code, program);
+      return true;
+    }
+    // Missing or rejected: fall back to a full compile.
+    glDeleteProgram(program);
+  }
+  // Compile shaders. Stages that are alive already, say the unchanged one
+  // on a hot reload, are shared instead.
+  bool compiled;
+  build_.vertex = ShaderRegistry::Stage(GL_VERTEX_SHADER, v_code, &compiled);
+  build_.fragment = ShaderRegistry::Stage(GL_FRAGMENT_SHADER, fr_code, &compiled);
+  build_.program = ShaderRegistry::AddProgram(
+      v_code, fr_code, CompileProgram(build_.vertex->id, build_.fragment->id));
+  build_.linked = true;
+  return true;
+}
+
+bool Shader::Ready() const {
+  if (!building_ || !build_.linked || gl_ext().MaxShaderCompilerThreads == nullptr) {
+    return true;
+  }
+  GLint done = GL_FALSE;
+  glGetProgramiv(build_.program->id, GL_COMPLETION_STATUS_KHR, &done);
+  return done == GL_TRUE;
+}
+
+bool Shader::Finish() {
+  if (!building_) {
+    return false;
+  }
+  Build build = std::move(build_);
+  build_ = Build();
+  building_ = false;
+  // Check both stages so every compile error gets printed.
+  bool compiled = true;
+  if (build.vertex != nullptr) {
+    compiled = CheckShader(build.vertex->id, build.vertex_source) && compiled;
+  }
+  if (build.fragment != nullptr) {
+    compiled = CheckShader(build.fragment->id, build.fragment_source) && compiled;
+  }
   // print linking errors if any.
   int success;
-  glGetProgramiv(id_, GL_LINK_STATUS, &success);
-  if (!success) {
+  glGetProgramiv(build.program->id, GL_LINK_STATUS, &success);
+  if (!compiled || !success) {
     char info_log[512];
-    glGetProgramInfoLog(id_, 512, NULL, info_log);
+    glGetProgramInfoLog(build.program->id, 512, NULL, info_log);
     std::cout << "program compile failed: " << info_log << std::endl;
+    // Dropping the handles deletes whatever no one else uses.
     return false;
   }
-  // delete the shaders.
-  glDeleteShader(vertex);
-  glDeleteShader(fragment);
+  if (build.linked && ProgramCache::enabled()) {
+    ProgramCache::Store(build.cache_key, build.program->id);
+  }
+  // Swap the new program in; the old one goes with its last handle.
+  program_ = std::move(build.program);
+  id_ = program_->id;
+  vertex_ = std::move(build.vertex);
+  fragment_ = std::move(build.fragment);
+  vertex_source_ = std::move(build.vertex_source);
+  fragment_source_ = std::move(build.fragment_source);
+  reflection_ = ProgramReflection::Reflect(id_);
+  // Keep the values set on the program being replaced, as a hot reload
+  // would otherwise reset them to GL's defaults.
+  std::shared_ptr<UniformShadow> previous = std::move(shadow_);
+  shadow_ = shadow_for(program_, reflection_);
+  if (previous != nullptr) {
+    shadow_->CarryOver(*previous);
+  }
+  LoadUniformLocations();
+  for (const auto& block : block_bindings_) {
+    BindUniformBlock(block.first, block.second);
+  }
   return true;
 }
 
-bool Shader::Init() {
-  std::string v_code = load_file(v_path_);
-  std::string fr_code = load_file(fr_path_);
-  // Compile shaders.
-  unsigned int vertex = CompileShader(GL_VERTEX_SHADER, v_code.c_str());
-  unsigned int fragment = CompileShader(GL_FRAGMENT_SHADER, fr_code.c_str());
-  std::cout<< "vertex shader: " << v_code << std::endl;
-  std::cout<< "fragment shader: " << fr_code << std::endl;
-  if (!CompileProgram(std::move(vertex), std::move(fragment))) {
+void Shader::Discard() {
+  build_ = Build();
+  building_ = false;
+}
+
+void Shader::BeginReload() {
+  Submit();
+}
+
+bool Shader::PollReload() {
+  if (!building_ || !Ready()) {
     return false;
   }
+  if (!Finish()) {
+    std::cout << "Keeping the previous " << v_path_ << " + " << fr_path_ << " program" << std::endl;
+    return false;
+  }
+  std::cout << "Reloaded " << v_path_ << " + " << fr_path_ << std::endl;
+  return true;
+}
+
+bool ShaderFuture::ready() const {
+  return shader_ == nullptr || shader_->Ready();
+}
+
+std::unique_ptr<Shader> ShaderFuture::get() {
+  std::unique_ptr<Shader> shader = std::move(shader_);
+  if (shader == nullptr || !shader->Finish()) {
+    std::cout << "Could not initialize shaders!";
+    return nullptr;
+  }
+  ShaderReloader::Watch(shader.get());
+  return shader;
+}
+
+Shader* Shader::Specialize(const UniformConstants& constants) {
+  auto inserted = specializations_.emplace(constants.key(), nullptr);
+  if (inserted.second) {
+    // Specializing a specialization adds to its constants.
+    UniformConstants merged = constants_;
+    for (const auto& constant : constants.values()) {
+      merged.SetExpression(constant.first, constant.second);
+    }
+    std::unique_ptr<Shader> s (new Shader(v_path_, fr_path_, defines_, merged));
+    // Blocks are read from the same binding points; Finish() applies them.
+    s->block_bindings_ = block_bindings_;
+    if (!s->Submit() || !s->Finish()) {
+      std::cout << "Could not specialize shaders!";
+      return nullptr;
+    }
+    ShaderReloader::Watch(s.get());
+    inserted.first->second = std::move(s);
+  }
+  return inserted.first->second.get();
+}
+
+bool Shader::BindUniformBlock(const std::string& name, GLuint binding) {
+  return BindUniformBlock(name, BlockBinding{binding, nullptr, 0, 0});
+}
+
+bool Shader::BindUniformBlock(const std::string& name, const BlockBinding& binding) {
+  block_bindings_[name] = binding;
+  if (binding.members != nullptr &&
+      !MatchesUniformBlock(reflection_, name.c_str(), binding.members, binding.member_count,
+                           binding.size)) {
+    return false;
+  }
+  const ReflectedBlock* block = reflection_.FindBlock(name);
+  if (block == nullptr) {
+    std::cout << "No uniform block " << name << " in " << v_path_ << " + " << fr_path_ << std::endl;
+    return false;
+  }
+  glUniformBlockBinding(id_, block->index, binding.binding);
+  reflection_.SetBlockBinding(block->index, binding.binding);
   return true;
 }
 
 void Shader::use() {
-  glUseProgram(id_);
+  GlState::UseProgram(id_);
+  shadow_->Commit();
+}
+
+void Shader::Commit() {
+  if (shadow_->dirty()) {
+    GlState::UseProgram(id_);
+    shadow_->Commit();
+  }
+}
+
+GLint Shader::GetUniformLocation(const std::string& name) const {
+  auto it = uniform_locations_.find(name);
+  return it != uniform_locations_.end() ? it->second : -1;
 }
 
 void Shader::setBool(const std::string &name, bool value) const
 {
-  glUniform1i(glGetUniformLocation(id_, name.c_str()), (int)value);
+  StageValue(GetUniformLocation(name), value);
 }
 
 void Shader::setInt(const std::string &name, int value) const
 {
-  glUniform1i(glGetUniformLocation(id_, name.c_str()), value);
+  StageValue(GetUniformLocation(name), value);
 }
 
 void Shader::setFloat(const std::string &name, float value) const
 {
-  glUniform1f(glGetUniformLocation(id_, name.c_str()), value);
+  StageValue(GetUniformLocation(name), value);
 }
 
 }
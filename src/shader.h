@@ -3,20 +3,154 @@
 
 #include <glad/glad.h>  // include glad to get all the required OpenGL headers
 
+#include "glsl_preprocessor.h"
+#include "glsl_types.h"
+#include "hash.h"
+#include "program_cache.h"
+#include "program_reflection.h"
+#include "shader_registry.h"
+#include "uniform_block.h"
+#include "uniform_shadow.h"
+
+#include <cstdint>
+#include <iterator>
+#include <map>
 #include <memory>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 namespace experimentgl {
 
+class Shader;
+
+// GL type of each type the uniform setters take: GLSL float, int, uint,
+// bool, vec2-4, mat4. 0 for anything else. UniformShadow::Stage() checks it
+// against the type the program declares.
+template <typename T>
+struct UniformValueType : std::integral_constant<GLenum, 0> {};
+template <> struct UniformValueType<float> : std::integral_constant<GLenum, GL_FLOAT> {};
+template <> struct UniformValueType<int> : std::integral_constant<GLenum, GL_INT> {};
+template <> struct UniformValueType<unsigned int>
+    : std::integral_constant<GLenum, GL_UNSIGNED_INT> {};
+template <> struct UniformValueType<bool> : std::integral_constant<GLenum, GL_BOOL> {};
+template <> struct UniformValueType<Vec2> : std::integral_constant<GLenum, GL_FLOAT_VEC2> {};
+template <> struct UniformValueType<Vec3> : std::integral_constant<GLenum, GL_FLOAT_VEC3> {};
+template <> struct UniformValueType<Vec4> : std::integral_constant<GLenum, GL_FLOAT_VEC4> {};
+template <> struct UniformValueType<Mat4> : std::integral_constant<GLenum, GL_FLOAT_MAT4> {};
+
+// Handle to a uniform of type T in one program. Resolved once through
+// Shader::uniform<T>(), after which Set() skips the name lookup. Like the
+// Shader setters, Set() only stages the value; see Shader::Commit().
+// Handles to uniforms the program does not have are valid no-ops. Handles
+// follow their shader through hot reloads and must not outlive it.
+template <typename T>
+class Uniform {
+ public:
+  static_assert(UniformValueType<T>::value != 0, "not a GLSL uniform type");
+  Uniform() : shader_(nullptr), location_(&kNoLocation) {}
+  Uniform(const Shader* shader, const GLint* location) : shader_(shader), location_(location) {}
+  void Set(const T& value) const;
+  // Stages 'count' array elements, starting at this one, for one upload.
+  void SetArray(const T* values, GLsizei count) const;
+  // False if the program has no active uniform of that name.
+  bool valid() const { return *location_ >= 0; }
+  GLint location() const { return *location_; }
+
+ private:
+  static constexpr GLint kNoLocation = -1;
+  const Shader* shader_;
+  // Entry in the shader's location table, which reloads update in place.
+  const GLint* location_;
+};
+
+// Compile-time id of a uniform name: "ourColor"_u is the FNV-1a hash of
+// "ourColor", usable as a template argument (Shader::set<"ourColor"_u>()).
+using UniformId = uint64_t;
+constexpr UniformId operator""_u(const char* name, size_t length) {
+  return Fnv1a64(name, length);
+}
+
+class ShaderFuture;
+
 class Shader {
 public:
-  // program ID
+  // program ID. Changes when the shader is hot reloaded, and is shared with
+  // every other Shader built from the same sources.
   unsigned int id_;
 
-  // Creates, initializes and returns the Shader.
-  static std::unique_ptr<Shader> Create(std::string vertex_path, std::string fragment_path);
-  // activate the shader.
+  // Creates, initializes and returns the Shader. Both files are run through
+  // PreprocessGlsl() with 'defines'.
+  static std::unique_ptr<Shader> Create(std::string vertex_path, std::string fragment_path,
+                                        const ShaderDefines& defines = ShaderDefines());
+  // Submits compile and link without waiting for either. Create several
+  // programs this way before asking for any of them, so the driver can build
+  // them in parallel (GL_KHR_parallel_shader_compile) or at least batch them.
+  static ShaderFuture CreateAsync(std::string vertex_path, std::string fragment_path,
+                                  const ShaderDefines& defines = ShaderDefines());
+  ~Shader();
+  // activate the shader, and upload the uniform values staged for it.
   void use();
+  // Uploads the uniform values staged since the last commit that differ from
+  // what the program holds, making the program current if there are any.
+  // Call right before drawing when values were set after use().
+  void Commit();
+  // Location of the active uniform 'name', or -1 if there is none. Served
+  // from a table filled in when the program links.
+  GLint GetUniformLocation(const std::string& name) const;
+  // Active uniforms, attributes and uniform blocks of the live program,
+  // queried when it linked.
+  const ProgramReflection& reflection() const { return reflection_; }
+  // Typed handle for hot loops; resolve it once, outside the loop.
+  template <typename T>
+  Uniform<T> uniform(const std::string& name) {
+    // Unknown names get a -1 entry too, in case a reload adds the uniform.
+    return Uniform<T>(this, &uniform_locations_.emplace(name, -1).first->second);
+  }
+  // Reads uniform block 'name' from binding point 'binding', where a
+  // UniformBuffer is bound. Survives hot reloads. Returns false if the
+  // program has no such block.
+  bool BindUniformBlock(const std::string& name, GLuint binding);
+  // Reads 'block' from its binding point, after checking that the driver
+  // laid the GLSL block out like the C++ struct.
+  template <typename Block>
+  bool BindUniformBlock(const UniformBlock<Block>& block) {
+    return BindUniformBlock<Block>(block.binding());
+  }
+  // Same for blocks streamed per draw.
+  template <typename Block>
+  bool BindUniformBlock(const UniformRing<Block>& ring) {
+    return BindUniformBlock<Block>(ring.binding());
+  }
+  // Variant of this shader with the uniforms in 'constants' baked in as GLSL
+  // constants the driver can fold. Setting those uniforms on the variant is
+  // a no-op, so callers can drop their per-frame uploads. Built on first use
+  // and owned by this shader; nullptr if it fails to build.
+  Shader* Specialize(const UniformConstants& constants);
+  // Location of the active uniform whose name hashes to 'id', or -1. A probe
+  // of an open-addressing table built when the program links; no strings
+  // and no allocation.
+  GLint FindLocation(UniformId id) const;
+  // Sets the uniform named by 'kId', e.g. set<"ourColor"_u>(Vec4{...}). T
+  // is float, int, unsigned int, bool, Vec2, Vec3, Vec4 or Mat4.
+  //
+  // Setters only stage the value in the program's UniformShadow; the
+  // program need not be in use. use() or Commit() uploads what changed, so
+  // setting the same value every frame costs no GL call.
+  template <UniformId kId, typename T>
+  void set(const T& value) const {
+    StageValue(FindLocation(kId), value);
+  }
+  // Sets 'count' elements of the uniform array named by 'kId', uploaded in
+  // one call.
+  template <UniformId kId, typename T>
+  void setArray(const T* values, GLsizei count) const {
+    StageArray(FindLocation(kId), values, count);
+  }
+  // Uniform values staged and uploads that reached GL, over all programs.
+  static long staged_uniforms() { return UniformShadow::staged(); }
+  static long elided_uniform_uploads() { return UniformShadow::elided(); }
   // util uniform functions.
   void setBool(const std::string& name, bool value) const;
   void setInt(const std::string& name, int value) const;
@@ -24,17 +158,148 @@ public:
 
  private:
   // Private ctor to force construction through Create().
-  Shader(std::string vertex_path, std::string fragment_path);
-  // returns 'false' if shader was not initialized.
-  bool Init();
-  // Given shader type and source, compile shader and return its id.
-  unsigned int CompileShader(unsigned int shader_type, const char* source);
-  // Compile program and store id_.
-  bool CompileProgram(unsigned int vertex, unsigned int fragment);
+  Shader(std::string vertex_path, std::string fragment_path, ShaderDefines defines,
+         UniformConstants constants = UniformConstants());
+  friend class ShaderFuture;
+  friend class ShaderReloader;
+  template <typename T>
+  friend class Uniform;
+
+  // A program that was submitted to the driver but not checked yet.
+  struct Build {
+    ProgramHandle program;
+    // Null when the program came from the cache or from another Shader.
+    StageHandle vertex;
+    StageHandle fragment;
+    GlslSource vertex_source;
+    GlslSource fragment_source;
+    // True if this build submitted the link (and so stores it in the cache).
+    bool linked = false;
+    // Program cache key of the sources; meaningful while the cache is enabled.
+    ProgramCacheKey cache_key;
+  };
+
+  // Loads the sources and starts compiling and linking them. Stages and
+  // programs that are already alive anywhere (see ShaderRegistry) or in the
+  // program cache are reused. Returns 'false' if nothing could be submitted.
+  bool Submit();
+  // True once Finish() would not block.
+  bool Ready() const;
+  // Waits for the submitted program and, if it linked, makes it the live
+  // one. Returns 'false' (keeping the live program) if it failed.
+  bool Finish();
+  // Drops a submitted program that was not finished.
+  void Discard();
+  // Hot reload: resubmits from the files. PollReload() swaps the result in
+  // once the driver is done and returns true if the program changed.
+  void BeginReload();
+  bool PollReload();
+  // Prints the info log of 'shader' if it failed to compile, along with the
+  // files its source string numbers refer to.
+  bool CheckShader(unsigned int shader, const GlslSource& source);
+  struct BlockBinding {
+    GLuint binding;
+    // C++ layout to check the block against, if any.
+    const Std140Member* members;
+    size_t member_count;
+    size_t size;
+  };
+  bool BindUniformBlock(const std::string& name, const BlockBinding& binding);
+  template <typename Block>
+  bool BindUniformBlock(GLuint binding) {
+    using Layout = UniformBlockLayout<Block>;
+    return BindUniformBlock(Layout::kName, BlockBinding{binding, Layout::kMembers,
+                                                        std::size(Layout::kMembers), sizeof(Block)});
+  }
+  // Start linking a program from the two stages and return its id.
+  unsigned int CompileProgram(unsigned int vertex, unsigned int fragment);
+  template <typename T>
+  void StageValue(GLint location, const T& value) const {
+    static_assert(UniformValueType<T>::value != 0, "not a GLSL uniform type");
+    shadow_->Stage(location, UniformValueType<T>::value, &value, sizeof(T));
+  }
+  // GL takes bools as ints.
+  void StageValue(GLint location, const bool& value) const {
+    int i = value;
+    shadow_->Stage(location, GL_BOOL, &i, sizeof(i));
+  }
+  template <typename T>
+  void StageArray(GLint location, const T* values, GLsizei count) const {
+    static_assert(UniformValueType<T>::value != 0, "not a GLSL uniform type");
+    static_assert(!std::is_same<T, bool>::value, "set bool arrays as int arrays");
+    shadow_->Stage(location, UniformValueType<T>::value, values, sizeof(T) * count);
+  }
+  // Refresh uniform_locations_ and location_table_ from reflection_.
+  void LoadUniformLocations();
   // Path to the vertex shader file.
   std::string v_path_;
   // Path to the vertex shader file.
   std::string fr_path_;
+  // Injected into both stages.
+  ShaderDefines defines_;
+  // Uniforms baked into both stages.
+  UniformConstants constants_;
+  // UniformConstants::key() -> variant built by Specialize().
+  std::unordered_map<std::string, std::unique_ptr<Shader>> specializations_;
+  // Interface of the live program.
+  ProgramReflection reflection_;
+  // Uniform values of the live program, shared with every Shader using it.
+  std::shared_ptr<UniformShadow> shadow_;
+  // Active uniform name -> location. Arrays are stored under their bare name.
+  // Entries are never erased, so Uniform<T> handles can point at them.
+  std::unordered_map<std::string, GLint> uniform_locations_;
+  // UniformId -> location, by linear probing. The size is a power of two
+  // with at least half the slots empty; empty slots have id 0.
+  struct LocationSlot {
+    UniformId id;
+    GLint location;
+  };
+  std::vector<LocationSlot> location_table_;
+  // Uniform block name -> binding, reapplied whenever the program changes.
+  std::map<std::string, BlockBinding> block_bindings_;
+  // The submitted program, while 'building_'.
+  Build build_;
+  bool building_ = false;
+  // The live program and its sources. Its stages are held on to so that a
+  // reload or another Shader with the same source shares them.
+  ProgramHandle program_;
+  StageHandle vertex_;
+  StageHandle fragment_;
+  GlslSource vertex_source_;
+  GlslSource fragment_source_;
+};
+
+template <typename T>
+void Uniform<T>::Set(const T& value) const {
+  if (shader_ != nullptr) {
+    shader_->StageValue(*location_, value);
+  }
+}
+
+template <typename T>
+void Uniform<T>::SetArray(const T* values, GLsizei count) const {
+  if (shader_ != nullptr) {
+    shader_->StageArray(*location_, values, count);
+  }
+}
+
+// A program being compiled and linked by the driver, returned by
+// Shader::CreateAsync(). Like std::future, get() can be called once.
+class ShaderFuture {
+ public:
+  ShaderFuture() = default;
+  // False once get() has been called, or if nothing could be submitted.
+  bool valid() const { return shader_ != nullptr; }
+  // True once get() will not block. Without GL_KHR_parallel_shader_compile
+  // the driver cannot report progress, and this is always true.
+  bool ready() const;
+  // Waits for the program and returns it, or nullptr if it failed to build.
+  std::unique_ptr<Shader> get();
+
+ private:
+  friend class Shader;
+  explicit ShaderFuture(std::unique_ptr<Shader> shader) : shader_(std::move(shader)) {}
+  std::unique_ptr<Shader> shader_;
 };
 
 }
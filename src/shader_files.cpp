@@ -0,0 +1,74 @@
+#include "shader_files.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace experimentgl {
+
+namespace {
+
+std::string override_directory;
+
+// 'path' with "." segments dropped and "dir/.." pairs folded.
+std::string normalize(const std::string& path) {
+  std::vector<std::string> segments;
+  std::istringstream in(path);
+  std::string segment;
+  while (std::getline(in, segment, '/')) {
+    if (segment.empty() || segment == ".") {
+      continue;
+    }
+    if (segment == ".." && !segments.empty() && segments.back() != "..") {
+      segments.pop_back();
+    } else {
+      segments.push_back(segment);
+    }
+  }
+  std::string normalized;
+  for (const std::string& s : segments) {
+    normalized += normalized.empty() ? s : "/" + s;
+  }
+  return normalized;
+}
+
+} // anonymous namespace.
+
+void ShaderFiles::SetOverrideDir(const std::string& directory) {
+  override_directory = directory;
+}
+
+const std::string& ShaderFiles::override_dir() {
+  return override_directory;
+}
+
+const EmbeddedFile* ShaderFiles::FindEmbedded(const std::string& path) {
+  std::string key = normalize(path);
+  const EmbeddedFile* end = kEmbeddedFiles + kNumEmbeddedFiles;
+  const EmbeddedFile* file = std::lower_bound(
+      kEmbeddedFiles, end, key,
+      [](const EmbeddedFile& file, const std::string& key) { return file.path < key; });
+  return file != end && file->path == key ? file : nullptr;
+}
+
+std::string ShaderFiles::DiskPath(const std::string& path) {
+  if (override_directory.empty() || override_directory == ".") {
+    return path;
+  }
+  return override_directory + "/" + path;
+}
+
+ShaderFile ShaderFiles::Open(const std::string& path) {
+  if (!override_directory.empty()) {
+    MappedFile mapping = MappedFile::Open(DiskPath(path));
+    if (mapping.valid()) {
+      return ShaderFile(std::move(mapping));
+    }
+  }
+  const EmbeddedFile* file = FindEmbedded(path);
+  return file == nullptr ? ShaderFile() : ShaderFile(*file);
+}
+
+}
@@ -0,0 +1,65 @@
+#ifndef SHADER_FILES_H_
+#define SHADER_FILES_H_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "mapped_file.h"
+
+namespace experimentgl {
+
+// A shader file compiled into the binary by embed_glsl.
+struct EmbeddedFile {
+  // Relative to src/, e.g. "vertex_shaders/triangle.vs".
+  const char* path;
+  const char* data;
+  size_t size;
+};
+
+// Generated from vertex_shaders/ and fragment_shaders/ at build time.
+extern const EmbeddedFile kEmbeddedFiles[];
+extern const size_t kNumEmbeddedFiles;
+
+// The contents of a shader file, read in place: either a read-only mapping
+// of the override file or the embedded copy. Valid while the object lives.
+class ShaderFile {
+ public:
+  ShaderFile() = default;
+  explicit ShaderFile(MappedFile mapping)
+      : mapping_(std::move(mapping)), contents_(mapping_.contents()), found_(true) {}
+  explicit ShaderFile(const EmbeddedFile& file)
+      : contents_(file.data, file.size), found_(true) {}
+
+  bool found() const { return found_; }
+  std::string_view contents() const { return contents_; }
+
+ private:
+  MappedFile mapping_;
+  std::string_view contents_;
+  bool found_ = false;
+};
+
+// Where shader sources come from. Every file under vertex_shaders/ and
+// fragment_shaders/ is embedded in the binary, so by default nothing is read
+// from disk and samples start from any working directory. An override
+// directory (--shader-dir) makes files found there win over the embedded
+// copies, which is how edits reach a running sample with --hot-reload.
+class ShaderFiles {
+ public:
+  // Reads files from 'directory' first. Empty means embedded copies only.
+  static void SetOverrideDir(const std::string& directory);
+  static const std::string& override_dir();
+  // The embedded copy of 'path', or nullptr. "./" and "dir/.." are resolved.
+  static const EmbeddedFile* FindEmbedded(const std::string& path);
+  // Where 'path' is looked for on disk. Only meaningful with an override
+  // directory.
+  static std::string DiskPath(const std::string& path);
+  // The contents of 'path': the override file if there is one, the embedded
+  // copy otherwise. Not found() if neither exists. Nothing is copied.
+  static ShaderFile Open(const std::string& path);
+};
+
+}
+#endif // SHADER_FILES_H_
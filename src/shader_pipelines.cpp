@@ -0,0 +1,136 @@
+#include "shader_pipelines.h"
+
+#include "gl_ext.h"
+#include "gl_resources.h"
+#include "gl_state.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace experimentgl {
+
+namespace {
+
+// Prints the info log of 'program' if it failed to link.
+bool check_program(GLuint program, const std::string& what) {
+  GLint success;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  if (!success) {
+    char info_log[512];
+    glGetProgramInfoLog(program, 512, NULL, info_log);
+    std::cout << what << " failed to link: " << info_log << std::endl;
+  }
+  return success;
+}
+
+} // anonymous namespace.
+
+ShaderPipelines::~ShaderPipelines() {
+  for (auto& combination : combinations_) {
+    if (combination.second == 0) {
+      continue;
+    }
+    DeleteGlResource(supported() ? GlResourceType::kProgramPipeline : GlResourceType::kProgram,
+                     combination.second, 0);
+  }
+  for (auto& stage : stages_) {
+    if (stage.second == nullptr) {
+      continue;
+    }
+    if (stage.second->program != 0) {
+      DeleteGlResource(GlResourceType::kProgram, stage.second->program, 0);
+    }
+    if (stage.second->shader != 0) {
+      glDeleteShader(stage.second->shader);
+    }
+  }
+}
+
+bool ShaderPipelines::supported() {
+  return gl_ext().CreateShaderProgramv != nullptr;
+}
+
+const ShaderStage* ShaderPipelines::Stage(GLenum type, const std::string& path,
+                                          const ShaderDefines& defines) {
+  std::string key = std::to_string(type) + " " + path + "\n" + DefinesKey(defines);
+  auto inserted = stages_.emplace(key, nullptr);
+  if (!inserted.second) {
+    return inserted.first->second.get();
+  }
+  // Failures stay cached as nullptr.
+  GlslSource source;
+  if (!PreprocessGlsl(path, defines, &source)) {
+    return nullptr;
+  }
+  std::unique_ptr<ShaderStage> stage(new ShaderStage{type, path});
+  const char* text = source.text.c_str();
+  GLint length = source.text.size();
+  if (supported()) {
+    // Compiles and links a single-stage separable program in one call.
+    stage->program = gl_ext().CreateShaderProgramv(type, 1, &text);
+    if (stage->program == 0) {
+      std::cout << path << " could not be built" << std::endl;
+      return nullptr;
+    }
+    GlResources::Track(GlResourceType::kProgram);
+    ++links_;
+    if (!check_program(stage->program, path)) {
+      DeleteGlResource(GlResourceType::kProgram, stage->program, 0);
+      return nullptr;
+    }
+  } else {
+    stage->shader = glCreateShader(type);
+    glShaderSource(stage->shader, 1, &text, &length);
+    glCompileShader(stage->shader);
+    GLint success;
+    glGetShaderiv(stage->shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+      char info_log[512];
+      glGetShaderInfoLog(stage->shader, 512, NULL, info_log);
+      std::cout << path << " failed to compile: " << info_log << std::endl;
+      glDeleteShader(stage->shader);
+      return nullptr;
+    }
+  }
+  inserted.first->second = std::move(stage);
+  return inserted.first->second.get();
+}
+
+bool ShaderPipelines::Use(const ShaderStage* vertex, const ShaderStage* fragment) {
+  if (vertex == nullptr || fragment == nullptr || vertex->type != GL_VERTEX_SHADER ||
+      fragment->type != GL_FRAGMENT_SHADER) {
+    return false;
+  }
+  auto inserted = combinations_.emplace(std::make_pair(vertex, fragment), 0);
+  GLuint& combination = inserted.first->second;
+  if (inserted.second) {
+    if (supported()) {
+      combination = CreateGlResource(GlResourceType::kProgramPipeline);
+      gl_ext().UseProgramStages(combination, GL_VERTEX_SHADER_BIT, vertex->program);
+      gl_ext().UseProgramStages(combination, GL_FRAGMENT_SHADER_BIT, fragment->program);
+    } else {
+      combination = CreateGlResource(GlResourceType::kProgram);
+      glAttachShader(combination, vertex->shader);
+      glAttachShader(combination, fragment->shader);
+      glLinkProgram(combination);
+      ++links_;
+      if (!check_program(combination, vertex->path + " + " + fragment->path)) {
+        DeleteGlResource(GlResourceType::kProgram, combination, 0);
+        combination = 0;
+      }
+    }
+  }
+  if (combination == 0) {
+    return false;
+  }
+  if (supported()) {
+    GlState::UseProgram(0);
+    GlState::BindProgramPipeline(combination);
+  } else {
+    GlState::UseProgram(combination);
+  }
+  return true;
+}
+
+}
@@ -0,0 +1,61 @@
+#ifndef SHADER_PIPELINES_H_
+#define SHADER_PIPELINES_H_
+
+#include <glad/glad.h>  // include glad to get all the required OpenGL headers
+
+#include "glsl_preprocessor.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace experimentgl {
+
+// One compiled shader stage, owned by ShaderPipelines.
+struct ShaderStage {
+  GLenum type;
+  std::string path;
+  // Separable program holding just this stage (ARB_separate_shader_objects),
+  // or 0 when the driver lacks pipelines.
+  GLuint program = 0;
+  // Shader object for linking monolithic programs when 'program' is 0.
+  GLuint shader = 0;
+};
+
+// Mixes vertex and fragment stages without relinking. Each stage is
+// compiled and linked once as a separable program, and every combination is
+// a program pipeline object that merely references the stages
+// (glUseProgramStages). Link operations therefore grow with the number of
+// unique stages, not with vertex x fragment combinations.
+//
+// Without separate shader objects, stages are compiled once and each
+// combination is linked into a monolithic program the first time it is used.
+class ShaderPipelines {
+ public:
+  ShaderPipelines() = default;
+  ~ShaderPipelines();
+  // True if the driver has program pipelines.
+  static bool supported();
+
+  // The stage built from 'path' with 'defines', compiled on first use.
+  // nullptr if it fails to build.
+  const ShaderStage* Stage(GLenum type, const std::string& path,
+                           const ShaderDefines& defines = ShaderDefines());
+  // Binds the combination of the two stages for drawing, creating it on
+  // first use. Returns false if they do not link together.
+  bool Use(const ShaderStage* vertex, const ShaderStage* fragment);
+  // Programs linked so far, separable or monolithic.
+  int links() const { return links_; }
+
+ private:
+  // (type, path, DefinesKey()) -> stage.
+  std::map<std::string, std::unique_ptr<ShaderStage>> stages_;
+  // (vertex, fragment) -> pipeline object, or monolithic program when
+  // pipelines are unsupported. 0 if the combination failed to link.
+  std::map<std::pair<const ShaderStage*, const ShaderStage*>, GLuint> combinations_;
+  int links_ = 0;
+};
+
+}
+#endif // SHADER_PIPELINES_H_
@@ -0,0 +1,153 @@
+#include "shader_registry.h"
+
+#include "gl_resources.h"
+#include "gl_state.h"
+#include "hash.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace experimentgl {
+
+namespace {
+
+struct StageEntry {
+  std::weak_ptr<const GlObject> object;
+  // Compared on lookup so a hash collision never shares the wrong stage.
+  std::string source;
+};
+
+struct ProgramEntry {
+  std::weak_ptr<const GlObject> object;
+  // Compared on lookup, like StageEntry::source.
+  std::string vertex_source;
+  std::string fragment_source;
+};
+
+struct Tables {
+  std::unordered_map<uint64_t, StageEntry> stages;
+  std::unordered_map<uint64_t, ProgramEntry> programs;
+  long shared_stages = 0;
+  long shared_programs = 0;
+};
+
+// Never destroyed: handles released during static destruction still find it.
+Tables& tables() {
+  static Tables* tables = new Tables();
+  return *tables;
+}
+
+uint64_t program_key(const std::string& vertex_source, const std::string& fragment_source) {
+  uint64_t vertex_key = ShaderRegistry::StageKey(GL_VERTEX_SHADER, vertex_source);
+  uint64_t fragment_key = ShaderRegistry::StageKey(GL_FRAGMENT_SHADER, fragment_source);
+  uint64_t key = Fnv1a64(reinterpret_cast<const char*>(&vertex_key), sizeof(vertex_key));
+  return Fnv1a64(reinterpret_cast<const char*>(&fragment_key), sizeof(fragment_key), key);
+}
+
+bool expired(const StageEntry& entry) {
+  return entry.object.expired();
+}
+
+bool expired(const ProgramEntry& entry) {
+  return entry.object.expired();
+}
+
+// Forgets 'key' unless it was taken over by a newer object in the meantime.
+template <typename Map>
+void erase_expired(Map& map, uint64_t key) {
+  auto it = map.find(key);
+  if (it != map.end() && expired(it->second)) {
+    map.erase(it);
+  }
+}
+
+} // anonymous namespace.
+
+uint64_t ShaderRegistry::StageKey(GLenum type, const std::string& source) {
+  return Fnv1a64(source, Fnv1a64(reinterpret_cast<const char*>(&type), sizeof(type)));
+}
+
+StageHandle ShaderRegistry::Stage(GLenum type, const std::string& source, bool* compiled) {
+  *compiled = false;
+  if (type != GL_VERTEX_SHADER && type != GL_FRAGMENT_SHADER) {
+    std::cout << "Invalid shader type given";
+    return nullptr;
+  }
+  uint64_t key = StageKey(type, source);
+  auto it = tables().stages.find(key);
+  if (it != tables().stages.end() && it->second.source == source) {
+    if (StageHandle stage = it->second.object.lock()) {
+      ++tables().shared_stages;
+      return stage;
+    }
+  }
+  GLuint shader = glCreateShader(type);
+  // Explicit length: the driver does not have to scan for the terminator.
+  const char* text = source.data();
+  GLint length = source.size();
+  glShaderSource(shader, 1, &text, &length);
+  // Compile status is checked by the caller later: asking for it now would
+  // make the driver finish this compile before taking the next one.
+  glCompileShader(shader);
+  *compiled = true;
+  StageHandle stage(new GlObject{shader, key}, [](const GlObject* object) {
+    glDeleteShader(object->id);
+    erase_expired(tables().stages, object->key);
+    delete object;
+  });
+  if (it == tables().stages.end() || expired(it->second)) {
+    tables().stages[key] = StageEntry{stage, source};
+  }
+  return stage;
+}
+
+ProgramHandle ShaderRegistry::FindProgram(const std::string& vertex_source,
+                                          const std::string& fragment_source) {
+  auto it = tables().programs.find(program_key(vertex_source, fragment_source));
+  if (it == tables().programs.end() || it->second.vertex_source != vertex_source ||
+      it->second.fragment_source != fragment_source) {
+    return nullptr;
+  }
+  ProgramHandle program = it->second.object.lock();
+  if (program != nullptr) {
+    ++tables().shared_programs;
+  }
+  return program;
+}
+
+ProgramHandle ShaderRegistry::AddProgram(const std::string& vertex_source,
+                                         const std::string& fragment_source, GLuint program) {
+  uint64_t key = program_key(vertex_source, fragment_source);
+  GlResources::Track(GlResourceType::kProgram);
+  ProgramHandle handle(new GlObject{program, key}, [](const GlObject* object) {
+    GlState::DeleteProgram(object->id);
+    GlResources::Untrack(GlResourceType::kProgram, 0);
+    erase_expired(tables().programs, object->key);
+    delete object;
+  });
+  auto it = tables().programs.find(key);
+  if (it == tables().programs.end() || expired(it->second)) {
+    tables().programs[key] = ProgramEntry{handle, vertex_source, fragment_source};
+  }
+  return handle;
+}
+
+size_t ShaderRegistry::live_stages() {
+  return tables().stages.size();
+}
+
+size_t ShaderRegistry::live_programs() {
+  return tables().programs.size();
+}
+
+long ShaderRegistry::shared_stages() {
+  return tables().shared_stages;
+}
+
+long ShaderRegistry::shared_programs() {
+  return tables().shared_programs;
+}
+
+}
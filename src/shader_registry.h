@@ -0,0 +1,53 @@
+#ifndef SHADER_REGISTRY_H_
+#define SHADER_REGISTRY_H_
+
+#include <glad/glad.h>  // include glad to get all the required OpenGL headers
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace experimentgl {
+
+// A GL shader or program object shared by everything built from the same
+// source. The object is deleted when the last handle to it goes away.
+struct GlObject {
+  GLuint id;
+  // Content hash the registry knows the object by.
+  uint64_t key;
+};
+using StageHandle = std::shared_ptr<const GlObject>;
+using ProgramHandle = std::shared_ptr<const GlObject>;
+
+// Process-wide table of live shader stages and linked programs, keyed by a
+// hash of their content, so identical stages are compiled and identical
+// programs linked once no matter how many Shaders ask for them. Both tables
+// also compare the sources, so a hash collision never shares the wrong
+// object. The table only holds weak references: handles do the refcounting.
+//
+// Programs are shared GL objects, and so is their uniform state.
+class ShaderRegistry {
+ public:
+  // Content hash of a stage's final source.
+  static uint64_t StageKey(GLenum type, const std::string& source);
+  // The live stage with this source, or a new one whose compile was just
+  // submitted (status is left for the caller to check). 'compiled' tells
+  // which. Returns nullptr for types other than vertex and fragment.
+  static StageHandle Stage(GLenum type, const std::string& source, bool* compiled);
+  // The live program linked from these stage sources, or nullptr.
+  static ProgramHandle FindProgram(const std::string& vertex_source,
+                                   const std::string& fragment_source);
+  // Takes ownership of 'program', linked from these stage sources, and
+  // shares it with later FindProgram() calls.
+  static ProgramHandle AddProgram(const std::string& vertex_source,
+                                  const std::string& fragment_source, GLuint program);
+
+  static size_t live_stages();
+  static size_t live_programs();
+  // Requests served by an object that was already alive.
+  static long shared_stages();
+  static long shared_programs();
+};
+
+}
+#endif // SHADER_REGISTRY_H_
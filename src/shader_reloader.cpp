@@ -0,0 +1,129 @@
+#include "shader_reloader.h"
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "shader.h"
+#include "shader_files.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace experimentgl {
+
+namespace {
+
+int inotify_fd = -1;
+// Watch descriptor -> directory it watches.
+std::unordered_map<int, std::string> directories;
+std::vector<Shader*> shaders;
+
+// Splits 'path' into the directory to watch and the file name in it.
+std::pair<std::string, std::string> split_path(const std::string& path) {
+  size_t slash = path.rfind('/');
+  if (slash == std::string::npos) {
+    return {".", path};
+  }
+  return {slash == 0 ? "/" : path.substr(0, slash), path.substr(slash + 1)};
+}
+
+void watch_directory(const std::string& directory) {
+  // Editors often save by renaming a temporary file over the original, which
+  // only shows up as IN_MOVED_TO in the directory.
+  int wd = inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+  if (wd < 0) {
+    std::cout << "Could not watch " << directory << " for shader changes" << std::endl;
+    return;
+  }
+  directories[wd] = directory;
+}
+
+} // anonymous namespace.
+
+bool ShaderReloader::Enable() {
+  if (inotify_fd >= 0) {
+    return true;
+  }
+  inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd < 0) {
+    std::cout << "inotify unavailable, shader hot reload disabled" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool ShaderReloader::enabled() {
+  return inotify_fd >= 0;
+}
+
+void ShaderReloader::Watch(Shader* shader) {
+  if (inotify_fd < 0) {
+    return;
+  }
+  // inotify hands out one descriptor per directory, so repeats are harmless.
+  for (const GlslSource* source : {&shader->vertex_source_, &shader->fragment_source_}) {
+    for (const std::string& path : source->files) {
+      watch_directory(split_path(ShaderFiles::DiskPath(path)).first);
+    }
+  }
+  if (std::find(shaders.begin(), shaders.end(), shader) == shaders.end()) {
+    shaders.push_back(shader);
+  }
+}
+
+void ShaderReloader::Unwatch(Shader* shader) {
+  shaders.erase(std::remove(shaders.begin(), shaders.end(), shader), shaders.end());
+}
+
+void ShaderReloader::Poll() {
+  if (inotify_fd < 0) {
+    return;
+  }
+  // True if 'file' (directory, name) went into the live program of 'shader'.
+  auto uses_file = [](const Shader& shader, const std::pair<std::string, std::string>& file) {
+    for (const GlslSource* source : {&shader.vertex_source_, &shader.fragment_source_}) {
+      for (const std::string& path : source->files) {
+        if (split_path(ShaderFiles::DiskPath(path)) == file) {
+          return true;
+        }
+      }
+    }
+    return false;
+  };
+  std::vector<Shader*> changed;
+  alignas(inotify_event) char buffer[4096];
+  ssize_t length;
+  while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+    const inotify_event* event;
+    for (char* p = buffer; p < buffer + length; p += sizeof(inotify_event) + event->len) {
+      event = reinterpret_cast<const inotify_event*>(p);
+      auto directory = directories.find(event->wd);
+      if (event->len == 0 || directory == directories.end()) {
+        continue;
+      }
+      std::pair<std::string, std::string> file(directory->second, event->name);
+      for (Shader* shader : shaders) {
+        if (uses_file(*shader, file) &&
+            std::find(changed.begin(), changed.end(), shader) == changed.end()) {
+          changed.push_back(shader);
+        }
+      }
+    }
+  }
+  for (Shader* shader : changed) {
+    std::cout << "Rebuilding " << shader->v_path_ << " + " << shader->fr_path_ << std::endl;
+    shader->BeginReload();
+  }
+  for (Shader* shader : shaders) {
+    if (shader->PollReload()) {
+      // The new sources may include files from other directories.
+      Watch(shader);
+    }
+  }
+}
+
+}
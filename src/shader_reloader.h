@@ -0,0 +1,32 @@
+#ifndef SHADER_RELOADER_H_
+#define SHADER_RELOADER_H_
+
+namespace experimentgl {
+
+class Shader;
+
+// Rebuilds shaders whose source files change on disk, using inotify on the
+// directories they live in. Changes are picked up by Poll(), which the
+// context calls between frames: the rebuild is submitted there and swapped in
+// by the first Poll() that finds the driver done with it, so a frame never
+// waits on the compiler when GL_KHR_parallel_shader_compile is available.
+// Only the stages whose source changed are recompiled. A source that fails
+// to compile or link leaves the previous program in place.
+//
+// Files are watched where ShaderFiles reads them from, so reloading needs an
+// override directory; Context uses the working directory if none is given.
+//
+// Shaders register themselves on creation while reloading is enabled.
+class ShaderReloader {
+ public:
+  // Starts watching. Returns false if inotify is unavailable.
+  static bool Enable();
+  static bool enabled();
+  static void Watch(Shader* shader);
+  static void Unwatch(Shader* shader);
+  // Starts rebuilds for changed files and swaps in the finished ones.
+  static void Poll();
+};
+
+}
+#endif // SHADER_RELOADER_H_
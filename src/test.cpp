@@ -1,41 +1,36 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "context.h"
+#include "gl_resources.h"
+#include "gl_state.h"
+#include "trace.h"
+
 #include <iostream>
 
-void framebuffer_size_callback(GLFWwindow* window, int width, int height);
-void processInput(GLFWwindow *window);
+using experimentgl::Context;
+using experimentgl::ContextOptions;
+using experimentgl::GlBuffer;
+using experimentgl::GlState;
+using experimentgl::ParseContextOptions;
+
+void processInput(Context *context);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
-int main()
+int main(int argc, char** argv)
 {
-    // glfw: initialize and configure
-    // ------------------------------
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    // glfw window creation
-    // --------------------
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
-    if (window == NULL)
-    {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
-    // glad: load all OpenGL function pointers
-    // ---------------------------------------
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    // Create the GL context: a GLFW window, or an offscreen FBO with --headless.
+    // --------------------------------------------------------------------------
+    ContextOptions options;
+    options.width = SCR_WIDTH;
+    options.height = SCR_HEIGHT;
+    options.title = "LearnOpenGL";
+    std::unique_ptr<Context> context = Context::Create(ParseContextOptions(argc, argv, options));
+    if (context == nullptr)
     {
-        std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
 
@@ -45,52 +40,44 @@ int main()
       0.0f, 0.5f, 0.0f
     };
 
-    unsigned int VBO;
-    glGenBuffers(1, &VBO);
+    GlBuffer VBO = GlBuffer::Create();
     // Buffer type of a vertex buffer is GL_ARRAY_BUFFER.
     // Bind newly created buffer to the GL_ARRAY_BUFFER target.
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GlState::BindBuffer(GL_ARRAY_BUFFER, VBO.get());
 
     // Copy vertices[] to buffer's memory using glBufferData.
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    VBO.SetBytes(sizeof(vertices));
 
     // render loop
     // -----------
-    while (!glfwWindowShouldClose(window))
+    while (!context->ShouldClose())
     {
         // input
         // -----
-        processInput(window);
+        {
+            TRACE_SCOPE("processInput");
+            processInput(context.get());
+        }
 
         // Rendering commands here.
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        context->SwapBuffers();
+        context->PollEvents();
     }
 
-    // glfw: terminate, clearing all previously allocated GLFW resources.
-    // ------------------------------------------------------------------
-    glfwTerminate();
+    // The context terminates GLFW (or tears down EGL) when it goes out of scope.
     return 0;
 }
 
-// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// process all input: query the context whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
-void processInput(GLFWwindow *window)
-{
-    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-        glfwSetWindowShouldClose(window, true);
-}
-
-// glfw: whenever the window size changed (by OS or user resize) this callback function executes
-// ---------------------------------------------------------------------------------------------
-void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+void processInput(Context *context)
 {
-    // make sure the viewport matches the new window dimensions; note that width and
-    // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
+    if(context->IsKeyPressed(GLFW_KEY_ESCAPE))
+        context->SetShouldClose();
 }
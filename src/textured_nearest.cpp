@@ -3,96 +3,173 @@
 #include <stb/stb_image.h>
 #include <GLFW/glfw3.h>
 
+#include "context.h"
+#include "gl_resources.h"
+#include "gl_state.h"
+#include "gpu_profiler.h"
+#include "mapped_file.h"
 #include "shader.h"
+#include "trace.h"
+#include "uniform_block.h"
+#include "vertex_format.h"
+#include "vertex_packing.h"
 
 #include <iostream>
 #include <cmath>
 
-void framebuffer_size_callback(GLFWwindow* window, int width, int height);
-void processInput(GLFWwindow *window);
+using experimentgl::Context;
+using experimentgl::ContextOptions;
+using experimentgl::FitPositions;
+using experimentgl::GlBuffer;
+using experimentgl::GlState;
+using experimentgl::GlTexture;
+using experimentgl::GpuScope;
+using experimentgl::Half2;
+using experimentgl::MappedFile;
+using experimentgl::MatchesVertexFormat;
+using experimentgl::PackHalf2;
+using experimentgl::PackSnorm10x3;
+using experimentgl::PackUnorm8x4;
+using experimentgl::ParseContextOptions;
+using experimentgl::PositionDequant;
+using experimentgl::Shader;
+using experimentgl::ShaderFuture;
+using experimentgl::Snorm10x3;
+using experimentgl::Std140Member;
+using experimentgl::UniformBlock;
+using experimentgl::Unorm8x4;
+using experimentgl::Vec2;
+using experimentgl::Vec3;
+using experimentgl::Vec4;
+using experimentgl::VertexArrayCache;
+using experimentgl::VertexAttribute;
+using experimentgl::VertexFormatOf;
+using experimentgl::kSnormGlMajor;
+using experimentgl::kSnormGlMinor;
+using experimentgl::operator""_u;
+
+// Layout of the Material block in fragment_shaders/material.glsl.
+struct Material {
+  Vec4 tint;
+  Vec2 uv_scale;
+  Vec2 uv_offset;
+  float brightness;
+};
+
+template <>
+struct experimentgl::UniformBlockLayout<Material> {
+  static constexpr const char* kName = "Material";
+  static constexpr Std140Member kMembers[] = {
+    STD140_MEMBER(Material, tint),
+    STD140_MEMBER(Material, uv_scale),
+    STD140_MEMBER(Material, uv_offset),
+    STD140_MEMBER(Material, brightness),
+  };
+};
+
+// One corner of the textured quad, as vertex_shaders/triangle_texture_packed.vs
+// reads it: 12 bytes where float attributes take 32. Positions are
+// normalized to the quad's bounding box, which the shader maps back.
+struct PackedTexturedVertex {
+  Snorm10x3 position;
+  Unorm8x4 color;
+  Half2 uv;
+};
+
+template <>
+struct experimentgl::VertexLayout<PackedTexturedVertex> {
+  static constexpr VertexAttribute kAttributes[] = {
+    VERTEX_ATTRIBUTE(PackedTexturedVertex, position, 0, "aPos"),
+    VERTEX_ATTRIBUTE(PackedTexturedVertex, color, 1, "aColor"),
+    VERTEX_ATTRIBUTE(PackedTexturedVertex, uv, 2, "aTexCoord"),
+  };
+};
+
+// Binding point every program reads Material from.
+const unsigned int MATERIAL_BINDING = 0;
+
+void processInput(Context *context);
 
 // settings
 const unsigned int SCR_WIDTH = 860;
 const unsigned int SCR_HEIGHT = 860;
 
-using experimentgl::Shader;
-
-int main()
+int main(int argc, char** argv)
 {
-  // glfw: initialize and configure
-  // ------------------------------
-  glfwInit();
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-  // glfw window creation
-  // --------------------
-  GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Experiments", NULL, NULL);
-  if (window == NULL)
-  {
-    std::cout << "Failed to create GLFW window" << std::endl;
-    glfwTerminate();
-    return -1;
-  }
-  glfwMakeContextCurrent(window);
-  glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
-  // glad: load all OpenGL function pointers
-  // ---------------------------------------
-  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+  // Create the GL context: a GLFW window, or an offscreen FBO with --headless.
+  // --------------------------------------------------------------------------
+  ContextOptions options;
+  options.width = SCR_WIDTH;
+  options.height = SCR_HEIGHT;
+  options.title = "Experiments";
+  // The packed positions assume GL 4.2's snorm conversion.
+  options.gl_major = kSnormGlMajor;
+  options.gl_minor = kSnormGlMinor;
+  std::unique_ptr<Context> context = Context::Create(ParseContextOptions(argc, argv, options));
+  if (context == nullptr)
   {
-    std::cout << "Failed to initialize GLAD" << std::endl;
     return -1;
   }
 
-  std::unique_ptr<Shader> shader = Shader::Create("vertex_shaders/triangle_texture.vs",
-                                                  "fragment_shaders/triangle_texture.fs");
+  // Let the driver build the program while buffers and the texture are set up.
+  ShaderFuture pending_shader = Shader::CreateAsync("vertex_shaders/triangle_texture_packed.vs",
+                                                    "fragment_shaders/triangle_texture.fs");
 
   // Add texture co-ordinates to vertices.
-  float vertices[] = {
-    // positions         // colors           // texture coords
-    0.5f,  0.5f, 0.0f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f,   // top right
-    0.5f, -0.5f, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f,   // bottom right
-    -0.5f, -0.5f, 0.0f,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f,   // bottom left
-    -0.5f,  0.5f, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f    // top left
+  const int NUM_VERTICES = 4;
+  Vec3 positions[NUM_VERTICES] = {
+    {0.5f,  0.5f, 0.0f},    // top right
+    {0.5f, -0.5f, 0.0f},    // bottom right
+    {-0.5f, -0.5f, 0.0f},   // bottom left
+    {-0.5f,  0.5f, 0.0f}    // top left
+  };
+  Vec3 colors[NUM_VERTICES] = {
+    {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f, 0.0f}
   };
+  Vec2 tex_coords[NUM_VERTICES] = {
+    {1.0f, 1.0f}, {1.0f, 0.0f}, {0.0f, 0.0f}, {0.0f, 1.0f}
+  };
+
+  // Quantize once at load: less to upload, and less for every vertex fetch
+  // to read.
+  PackedTexturedVertex vertices[NUM_VERTICES];
+  PositionDequant dequant = FitPositions(positions, NUM_VERTICES);
+  PackSnorm10x3(positions, NUM_VERTICES, dequant, &vertices[0].position,
+                sizeof(PackedTexturedVertex)).Print("positions");
+  PackUnorm8x4(colors, NUM_VERTICES, &vertices[0].color,
+               sizeof(PackedTexturedVertex)).Print("colors");
+  PackHalf2(tex_coords, NUM_VERTICES, &vertices[0].uv,
+            sizeof(PackedTexturedVertex)).Print("texture coords");
+  std::cout << "Vertex size " << sizeof(PackedTexturedVertex) << " bytes, "
+            << sizeof(Vec3) * 2 + sizeof(Vec2) << " as floats" << std::endl;
   unsigned int indices[] = {
     0, 1, 3, // first triangle.
     1, 2, 3  // second triangle.
   };
-  unsigned int VBO, EBO, VAO;
-  glGenVertexArrays(1, &VAO);
-  glGenBuffers(1, &VBO);
-  glGenBuffers(1, &EBO);
+  GlBuffer VBO = GlBuffer::Create();
+  GlBuffer EBO = GlBuffer::Create();
 
-  glBindVertexArray(VAO);
+  // Attribute pointers come from PackedTexturedVertex's layout, with EBO as
+  // the VAO's element buffer.
+  VertexArrayCache vertex_arrays;
+  GLuint VAO = vertex_arrays.Get<PackedTexturedVertex>(VBO.get(), EBO.get());
 
   // Copy vertices[] to buffer's memory using glBufferData.
   // glBufferDtata is a function used to copy user-defined data into the "currently bound" buffer.
-  glBindBuffer(GL_ARRAY_BUFFER, VBO);
+  // Get() does not promise any bindings, so bind both buffers here; the
+  // element buffer binding belongs to the VAO.
+  GlState::BindVertexArray(VAO);
+  GlState::BindBuffer(GL_ARRAY_BUFFER, VBO.get());
   glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+  VBO.SetBytes(sizeof(vertices));
 
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+  GlState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO.get());
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-  glVertexAttribPointer(/* attribute location = 0 */ 0, /* size of attribute */ 3,
-                        GL_FLOAT, /*data to be normalized?*/ GL_FALSE,
-                        /* stride or space b/w consecutive vertex attributes*/ 8 * sizeof(float),
-                        /* offset where position begins in the buffer */ (void*)0);
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(/* attribute location = 1 */ 1, /* size of attribute */ 3,
-                        GL_FLOAT, /*data to be normalized?*/ GL_FALSE,
-                        /* stride or space b/w consecutive vertex attributes*/ 8 * sizeof(float),
-                        /* offset where position begins in the buffer */ (void*)(3* sizeof(float)));
-  glEnableVertexAttribArray(1);
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-  glEnableVertexAttribArray(2);
+  EBO.SetBytes(sizeof(indices));
 
   // Create texture.
-  unsigned int texture;
-  glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
+  GlTexture texture = GlTexture::Create();
+  GlState::BindTexture(0, GL_TEXTURE_2D, texture.get());
   // Texture wrapping. What happens if we specify texture co-ordinates outside of 0.0f to 1.0f?.
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
@@ -106,7 +183,15 @@ int main()
   //  unsigned char *data = stbi_load("/home/kirtivr/opengl/src/textures/texture_d.png", &width, &height, &nr_channels, 0);
   //  unsigned char *data = stbi_load("textures/container.jpg", &width, &height, &nr_channels, 0);
 
-  unsigned char *data = stbi_load("textures/texture_d.png", &width, &height, &nr_channels, 0);
+  // Decoded straight out of the page cache; the mapping is released once the
+  // image is decoded.
+  unsigned char *data = nullptr;
+  {
+    MappedFile image = MappedFile::Open("textures/texture_d.png");
+    if (image.valid()) {
+      data = stbi_load_from_memory(image.data(), image.size(), &width, &height, &nr_channels, 0);
+    }
+  }
 
   if (data) {
     std::cout << "width = " << width << " height= " << height;
@@ -114,60 +199,79 @@ int main()
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
     // Generate all required mipmaps for currently bound texture.
     glGenerateMipmap(GL_TEXTURE_2D);
+    // RGB8 plus a third more for the mip chain.
+    texture.SetBytes(static_cast<GLsizeiptr>(width) * height * 3 * 4 / 3);
   } else {
     std::cout << "Failed to load texture!." << std::endl;
   }
   // Can free image memory now!.
-  //stbi_image_free(data);
+  stbi_image_free(data);
+
+  std::unique_ptr<Shader> shader = pending_shader.get();
+  if (shader == nullptr ||
+      !MatchesVertexFormat(shader->reflection(), VertexFormatOf<PackedTexturedVertex>()))
+  {
+    return -1;
+  }
+  // Staged once; use() uploads them on the first draw.
+  shader->set<"positionScale"_u>(dequant.scale);
+  shader->set<"positionOffset"_u>(dequant.offset);
+  std::unique_ptr<UniformBlock<Material>> material = UniformBlock<Material>::Create(MATERIAL_BINDING);
+  if (material == nullptr || !shader->BindUniformBlock(*material))
+  {
+    return -1;
+  }
+  Material material_values = {{1.0f, 1.0f, 1.0f, 1.0f}, {1.0f, 1.0f}, {0.0f, 0.0f}, 1.0f};
 
   // render loop
   // -----------
-  while (!glfwWindowShouldClose(window))
+  while (!context->ShouldClose())
   {
     // input
     // -----
-    processInput(window);
+    {
+      TRACE_SCOPE("processInput");
+      processInput(context.get());
+    }
 
     // Rendering commands here.
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
     // Bind texture.
-    glBindTexture(GL_TEXTURE_2D, texture);
+    GlState::BindTexture(0, GL_TEXTURE_2D, texture.get());
+
+    {
+      TRACE_SCOPE("uniform updates");
+      // Every material parameter goes up in one buffer update.
+      material_values.brightness = 0.75f + 0.25f * sin(context->GetTime());
+      material->Update(material_values);
+    }
 
     // Render container.
-    shader->use();
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+    {
+      TRACE_SCOPE("draw submission");
+      // Time the textured quad on the GPU (reported with --gpu-profile).
+      GpuScope scope("textured_quad");
+      shader->use();
+      GlState::BindVertexArray(VAO);
+      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    }
+    // swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
     // -------------------------------------------------------------------------------
-    glfwSwapBuffers(window);
-    glfwPollEvents();
+    context->SwapBuffers();
+    context->PollEvents();
   }
 
-  // glfw: terminate, clearing all previously allocated GLFW resources.
-  // ------------------------------------------------------------------
-  glDeleteVertexArrays(1, &VAO);
-  glDeleteBuffers(1, &VBO);
-  glDeleteBuffers(1, &EBO);
-  // Terminate, clearing all previously allocated GLFW resources.
-  glfwTerminate();
+  // The handles above delete their objects before the context goes away.
+  // The context terminates GLFW (or tears down EGL) when it goes out of scope.
   return 0;
 }
 
-// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// process all input: query the context whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
-void processInput(GLFWwindow *window)
-{
-  if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-    glfwSetWindowShouldClose(window, true);
-}
-
-// glfw: whenever the window size changed (by OS or user resize) this callback function executes
-// ---------------------------------------------------------------------------------------------
-void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+void processInput(Context *context)
 {
-  // make sure the viewport matches the new window dimensions; note that width and
-  // height will be significantly larger than specified on retina displays.
-  glViewport(0, 0, width, height);
+  if(context->IsKeyPressed(GLFW_KEY_ESCAPE))
+    context->SetShouldClose();
 }
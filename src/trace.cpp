@@ -0,0 +1,127 @@
+#include "trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace experimentgl {
+
+namespace {
+
+// Events kept per thread before new ones are dropped.
+const size_t kEventsPerThread = 1 << 16;
+
+struct Event {
+  const char* name;
+  uint64_t begin_us;
+  uint64_t end_us;
+};
+
+// Written only by its owning thread. 'size' is published with release
+// semantics after the event is filled in, so a reader that acquires it sees
+// complete events.
+struct ThreadBuffer {
+  explicit ThreadBuffer(int tid) : tid(tid), events(new Event[kEventsPerThread]) {}
+  int tid;
+  std::unique_ptr<Event[]> events;
+  std::atomic<size_t> size{0};
+  std::atomic<size_t> dropped{0};
+};
+
+std::atomic<bool> trace_enabled{false};
+const std::chrono::steady_clock::time_point trace_epoch = std::chrono::steady_clock::now();
+
+// Every buffer ever registered. Buffers are never freed so the dump can still
+// read events of threads that have exited.
+std::mutex registry_mutex;
+std::vector<ThreadBuffer*>& registry() {
+  static std::vector<ThreadBuffer*>* buffers = new std::vector<ThreadBuffer*>();
+  return *buffers;
+}
+
+ThreadBuffer* thread_buffer() {
+  thread_local ThreadBuffer* buffer = nullptr;
+  if (buffer == nullptr) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    buffer = new ThreadBuffer(registry().size() + 1);
+    registry().push_back(buffer);
+  }
+  return buffer;
+}
+
+void write_escaped(std::ofstream& out, const char* s) {
+  for (; *s; ++s) {
+    if (*s == '"' || *s == '\\') {
+      out << '\\';
+    }
+    out << *s;
+  }
+}
+
+} // anonymous namespace.
+
+void Trace::Enable() {
+  trace_enabled.store(true, std::memory_order_relaxed);
+}
+
+bool Trace::enabled() {
+  return trace_enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t Trace::Now() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - trace_epoch).count();
+}
+
+void Trace::Record(const char* name, uint64_t begin_us, uint64_t end_us) {
+  ThreadBuffer* buffer = thread_buffer();
+  size_t size = buffer->size.load(std::memory_order_relaxed);
+  if (size == kEventsPerThread) {
+    buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  buffer->events[size] = {name, begin_us, end_us};
+  buffer->size.store(size + 1, std::memory_order_release);
+}
+
+bool Trace::WriteJson(const std::string& path) {
+  std::ofstream out(path);
+  if (!out) {
+    std::cout << "Could not write trace to " << path << std::endl;
+    return false;
+  }
+  std::vector<ThreadBuffer*> buffers;
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    buffers = registry();
+  }
+  out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  bool first = true;
+  size_t dropped = 0;
+  for (ThreadBuffer* buffer : buffers) {
+    size_t size = buffer->size.load(std::memory_order_acquire);
+    dropped += buffer->dropped.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < size; ++i) {
+      const Event& e = buffer->events[i];
+      out << (first ? "\n" : ",\n") << "{\"name\": \"";
+      write_escaped(out, e.name);
+      out << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->tid
+          << ", \"ts\": " << e.begin_us << ", \"dur\": " << e.end_us - e.begin_us << "}";
+      first = false;
+    }
+  }
+  out << "\n]}\n";
+  std::cout << "Wrote trace to " << path;
+  if (dropped > 0) {
+    std::cout << " (" << dropped << " events dropped)";
+  }
+  std::cout << std::endl;
+  return true;
+}
+
+}
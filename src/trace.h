@@ -0,0 +1,53 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <cstdint>
+#include <string>
+
+namespace experimentgl {
+
+// CPU-side tracing of named phases, exported in the chrome://tracing (and
+// Perfetto) JSON format. Each thread appends to its own fixed-size buffer with
+// no locks on the recording path; a full buffer drops new events. Recording
+// is off until Trace::Enable() so TRACE_SCOPE costs one load otherwise.
+class Trace {
+ public:
+  static void Enable();
+  static bool enabled();
+  // Microseconds on the trace clock.
+  static uint64_t Now();
+  // Appends a complete event to the calling thread's buffer. 'name' must
+  // outlive the trace, e.g. a string literal.
+  static void Record(const char* name, uint64_t begin_us, uint64_t end_us);
+  // Writes every recorded event as chrome://tracing JSON. Safe to call while
+  // other threads keep recording; their newest events may be missed.
+  static bool WriteJson(const std::string& path);
+};
+
+// Records the time between its construction and destruction as one event.
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name)
+      : name_(Trace::enabled() ? name : nullptr), begin_(name_ ? Trace::Now() : 0) {}
+  ~TraceScope() {
+    if (name_ != nullptr) {
+      Trace::Record(name_, begin_, Trace::Now());
+    }
+  }
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  const char* name_;
+  uint64_t begin_;
+};
+
+}
+
+#define TRACE_CONCAT_INNER_(a, b) a##b
+#define TRACE_CONCAT_(a, b) TRACE_CONCAT_INNER_(a, b)
+// Traces the rest of the enclosing block as 'name'.
+#define TRACE_SCOPE(name) \
+  ::experimentgl::TraceScope TRACE_CONCAT_(trace_scope_, __LINE__)(name)
+
+#endif // TRACE_H_
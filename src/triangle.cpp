@@ -1,113 +1,40 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "context.h"
+#include "gl_resources.h"
+#include "gl_state.h"
+#include "shader_pipelines.h"
+#include "trace.h"
+
 #include <iostream>
 
-void framebuffer_size_callback(GLFWwindow* window, int width, int height);
-void processInput(GLFWwindow *window);
+using experimentgl::Context;
+using experimentgl::ContextOptions;
+using experimentgl::GlBuffer;
+using experimentgl::GlState;
+using experimentgl::GlVertexArray;
+using experimentgl::ParseContextOptions;
+using experimentgl::ShaderPipelines;
+using experimentgl::ShaderStage;
+
+void processInput(Context *context);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
-unsigned int compileVertexShader() {
-  // Source for vertex shader.
-  const char *vertex_shader_source = "#version 330 core\n"
-                                     "layout (location = 0) in vec3 aPos;\n"
-                                     "void main()\n"
-                                     "{\n"
-                                     "  gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);\n"
-                                     "}\0";
-  unsigned int vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-  // Attach the shader source code to the shader object and compile the shader.
-  glShaderSource(vertex_shader, /*how many strings are we passing*/ 1, &vertex_shader_source, NULL);
-  glCompileShader(vertex_shader);
-
-  // Check if compilation was successful.
-  int success;
-  char  msg[512];
-  glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &success);
-  if (!success) {
-    glGetShaderInfoLog(vertex_shader, 512, NULL, msg);
-    std::cout << "VERTEX SHADER COMPILATION FAILED\n" << msg << std::endl;
-  }
-  return vertex_shader;
-}
-
-unsigned int compileFragmentShader1() {
-  const char *frag_shader_source = "#version 330 core\n"
-                                   // Output variable FragColor.
-                                   "out vec4 FragColor;\n\n"
-                                   "void main()\n"
-                                   "{\n"
-                                   "  FragColor = vec4(1.0f, 0.5f, 0.2f, 1.0f);\n"
-                                   "}\n\0";
-  unsigned int frag_shader = glCreateShader(GL_FRAGMENT_SHADER);
-  // Attach the shader source code to the shader object and compile the shader.
-  glShaderSource(frag_shader, /*how many strings are we passing*/ 1, &frag_shader_source, NULL);
-  glCompileShader(frag_shader);
-
-  // Check if compilation was successful.
-  int success;
-  char  msg[512];
-  glGetShaderiv(frag_shader, GL_COMPILE_STATUS, &success);
-  if (!success) {
-    glGetShaderInfoLog(frag_shader, 512, NULL, msg);
-    std::cout << "FRAG SHADER COMPILATION FAILED\n" << msg << std::endl;
-  }
-  return frag_shader;
-}
-
-unsigned int compileFragmentShader2() {
-  const char *frag_shader_source = "#version 330 core\n"
-                                   // Output variable FragColor.
-                                   "out vec4 FragColor;\n\n"
-                                   "void main()\n"
-                                   "{\n"
-                                   "  FragColor = vec4(1.0f, 1.0f, 0.2f, 1.0f);\n"
-                                   "}\n\0";
-  unsigned int frag_shader = glCreateShader(GL_FRAGMENT_SHADER);
-  // Attach the shader source code to the shader object and compile the shader.
-  glShaderSource(frag_shader, /*how many strings are we passing*/ 1, &frag_shader_source, NULL);
-  glCompileShader(frag_shader);
-
-  // Check if compilation was successful.
-  int success;
-  char  msg[512];
-  glGetShaderiv(frag_shader, GL_COMPILE_STATUS, &success);
-  if (!success) {
-    glGetShaderInfoLog(frag_shader, 512, NULL, msg);
-    std::cout << "FRAG SHADER COMPILATION FAILED\n" << msg << std::endl;
-  }
-  return frag_shader;
-}
-
-int main()
+int main(int argc, char** argv)
 {
-    // glfw: initialize and configure
-    // ------------------------------
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    // glfw window creation
-    // --------------------
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
-    if (window == NULL)
+    // Create the GL context: a GLFW window, or an offscreen FBO with --headless.
+    // --------------------------------------------------------------------------
+    ContextOptions options;
+    options.width = SCR_WIDTH;
+    options.height = SCR_HEIGHT;
+    options.title = "LearnOpenGL";
+    std::unique_ptr<Context> context = Context::Create(ParseContextOptions(argc, argv, options));
+    if (context == nullptr)
     {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
-    // glad: load all OpenGL function pointers
-    // ---------------------------------------
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-    {
-        std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
 
@@ -122,19 +49,18 @@ int main()
       -0.25f, 0.25f, 0.0f
     };
     // Bind VAO.
-    unsigned int VAOs[2];
-    glGenVertexArrays(2, VAOs);
+    GlVertexArray VAOs[2] = {GlVertexArray::Create(), GlVertexArray::Create()};
     // Buffer type of a vertex buffer is GL_ARRAY_BUFFER.
     // Bind newly created buffer to the GL_ARRAY_BUFFER target.
-    unsigned int VBOs[2];
-    glGenBuffers(2, VBOs);
+    GlBuffer VBOs[2] = {GlBuffer::Create(), GlBuffer::Create()};
 
     // First triangle setup.
-    glBindVertexArray(VAOs[0]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[0]);
+    GlState::BindVertexArray(VAOs[0].get());
+    GlState::BindBuffer(GL_ARRAY_BUFFER, VBOs[0].get());
     // Copy vertices[] to buffer's memory using glBufferData.
     // glBufferDtata is a function used to copy user-defined data into the "currently bound" buffer.
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices1), vertices1, GL_STATIC_DRAW);
+    VBOs[0].SetBytes(sizeof(vertices1));
     glVertexAttribPointer(/* attribute location = 0 */ 0, /* size of attribute */ 3,
                           GL_FLOAT, /*data to be normalized?*/ GL_FALSE,
                           /* stride or space b/w consecutive vertex attributes*/ 3 * sizeof(float),
@@ -142,9 +68,10 @@ int main()
     glEnableVertexAttribArray(0);
 
     // Second triangle setup.
-    glBindVertexArray(VAOs[1]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[1]);
+    GlState::BindVertexArray(VAOs[1].get());
+    GlState::BindBuffer(GL_ARRAY_BUFFER, VBOs[1].get());
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices2), vertices2, GL_STATIC_DRAW);
+    VBOs[1].SetBytes(sizeof(vertices2));
 
     // Set the vertex attribute pointers.
     glVertexAttribPointer(/* attribute location = 0 */ 0, /* size of attribute */ 3,
@@ -154,86 +81,58 @@ int main()
     // Vertex attributes are disabled by default.
     // Give vertex attribute location as argument.
     glEnableVertexAttribArray(0);
-    unsigned int vs = compileVertexShader();
-    unsigned int fs1 = compileFragmentShader1();
-    unsigned int fs2 = compileFragmentShader2();
-    // Shader program: multiple shaders combined.
-    // Links output of each shader to the input of the next shader.
-    unsigned int sp1 = glCreateProgram();
-    glAttachShader(sp1, vs);
-    glAttachShader(sp1, fs1);
-    glLinkProgram(sp1);
-    // Check if linking was successful.
-    int success;
-    char msg[512];
-    glGetShaderiv(sp1, GL_LINK_STATUS, &success);
-    if (!success) {
-      glGetShaderInfoLog(sp1, 512, NULL, msg);
-      std::cout << "SHADER LINK FAILED\n" << msg << std::endl;
-    }
-    // Shader program: multiple shaders combined.
-    // Links output of each shader to the input of the next shader.
-    unsigned int sp2 = glCreateProgram();
-    glAttachShader(sp2, vs);
-    glAttachShader(sp2, fs2);
-    glLinkProgram(sp2);
-    // Check if linking was successful.
-    glGetShaderiv(sp2, GL_LINK_STATUS, &success);
-    if (!success) {
-      glGetShaderInfoLog(sp2, 512, NULL, msg);
-      std::cout << "SHADER LINK FAILED\n" << msg << std::endl;
+    // One vertex stage shared by two fragment stages that differ only by the
+    // injected color. Each stage is linked once; the two combinations are
+    // pipeline objects rather than two more linked programs.
+    ShaderPipelines pipelines;
+    const ShaderStage* position = pipelines.Stage(GL_VERTEX_SHADER, "vertex_shaders/position.vs");
+    const ShaderStage* orange = pipelines.Stage(GL_FRAGMENT_SHADER, "fragment_shaders/solid_color.fs",
+                                                {{"COLOR", "vec4(1.0f, 0.5f, 0.2f, 1.0f)"}});
+    const ShaderStage* yellow = pipelines.Stage(GL_FRAGMENT_SHADER, "fragment_shaders/solid_color.fs",
+                                                {{"COLOR", "vec4(1.0f, 1.0f, 0.2f, 1.0f)"}});
+    if (position == nullptr || orange == nullptr || yellow == nullptr)
+    {
+        return -1;
     }
 
-    glUseProgram(sp1);
-    glUseProgram(sp2);
-    // Once linked we do not need them anymore.
-    glDeleteShader(vs);
-    glDeleteShader(fs1);
-    glDeleteShader(fs2);
-
     // render loop
     // -----------
-    while (!glfwWindowShouldClose(window))
+    while (!context->ShouldClose())
     {
         // input
         // -----
-        processInput(window);
+        {
+            TRACE_SCOPE("processInput");
+            processInput(context.get());
+        }
 
         // Rendering commands here.
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
-        glUseProgram(sp1);
-        glBindVertexArray(VAOs[0]);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
-        glUseProgram(sp2);
-        glBindVertexArray(VAOs[1]);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
+        {
+            TRACE_SCOPE("draw submission");
+            pipelines.Use(position, orange);
+            GlState::BindVertexArray(VAOs[0].get());
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            pipelines.Use(position, yellow);
+            GlState::BindVertexArray(VAOs[1].get());
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
         // glDrawArrays(GL_TRIANGLES, 0, 3);
-        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        context->SwapBuffers();
+        context->PollEvents();
     }
 
-    // glfw: terminate, clearing all previously allocated GLFW resources.
-    // ------------------------------------------------------------------
-    glfwTerminate();
+    // The context terminates GLFW (or tears down EGL) when it goes out of scope.
     return 0;
 }
 
-// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// process all input: query the context whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
-void processInput(GLFWwindow *window)
-{
-    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-        glfwSetWindowShouldClose(window, true);
-}
-
-// glfw: whenever the window size changed (by OS or user resize) this callback function executes
-// ---------------------------------------------------------------------------------------------
-void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+void processInput(Context *context)
 {
-    // make sure the viewport matches the new window dimensions; note that width and
-    // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
+    if(context->IsKeyPressed(GLFW_KEY_ESCAPE))
+        context->SetShouldClose();
 }
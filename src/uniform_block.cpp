@@ -0,0 +1,85 @@
+#include "uniform_block.h"
+
+#include "gl_state.h"
+
+#include <iostream>
+#include <string>
+
+namespace experimentgl {
+
+bool MatchesUniformBlock(const ProgramReflection& reflection, const char* name,
+                         const Std140Member* members, size_t member_count, size_t size) {
+  const ReflectedBlock* block = reflection.FindBlock(name);
+  if (block == nullptr) {
+    std::cout << "No uniform block " << name << " in the program" << std::endl;
+    return false;
+  }
+  bool matches = true;
+  if (static_cast<size_t>(block->data_size) > Std140RoundUp(size, 16)) {
+    std::cout << "Uniform block " << name << " is " << block->data_size << " bytes, its struct "
+              << size << std::endl;
+    matches = false;
+  }
+  GLint position = block - reflection.blocks().data();
+  for (const ReflectedUniform& uniform : reflection.uniforms()) {
+    if (uniform.block != position) {
+      continue;
+    }
+    // "Block.member" for blocks with an instance name.
+    std::string member_name = uniform.name.substr(uniform.name.rfind('.') + 1);
+    const Std140Member* member = nullptr;
+    for (size_t j = 0; j < member_count; ++j) {
+      if (member_name == members[j].name) {
+        member = &members[j];
+        break;
+      }
+    }
+    if (member == nullptr) {
+      std::cout << name << "." << member_name << " has no C++ member" << std::endl;
+      matches = false;
+    } else if (static_cast<size_t>(uniform.offset) != member->offset ||
+               uniform.type != member->gl_type) {
+      std::cout << name << "." << member_name << " is at offset " << uniform.offset
+                << " with type 0x" << std::hex << uniform.type << ", its C++ member at "
+                << std::dec << member->offset << " with type 0x" << std::hex
+                << member->gl_type << std::dec << std::endl;
+      matches = false;
+    }
+  }
+  return matches;
+}
+
+GLsizeiptr UniformBufferOffsetAlignment() {
+  GLint alignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  return alignment > 0 ? alignment : 256;
+}
+
+GlBuffer UniformBuffer::CreateBuffer(GLuint binding, GLsizeiptr size) {
+  GLint max_bindings = 0;
+  glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &max_bindings);
+  if (binding >= static_cast<GLuint>(max_bindings)) {
+    std::cout << "Uniform buffer binding " << binding << " is out of range (max "
+              << max_bindings << ")" << std::endl;
+    return GlBuffer();
+  }
+  GlBuffer buffer = GlBuffer::Create();
+  GlState::BindBuffer(GL_UNIFORM_BUFFER, buffer.get());
+  // Rewritten whole, typically every frame. The driver may read up to the
+  // std140 size of the block, which pads its end to a vec4.
+  glBufferData(GL_UNIFORM_BUFFER, Std140RoundUp(size, 16), NULL, GL_DYNAMIC_DRAW);
+  buffer.SetBytes(Std140RoundUp(size, 16));
+  GlState::BindBufferBase(GL_UNIFORM_BUFFER, binding, buffer.get());
+  return buffer;
+}
+
+void UniformBuffer::Bind() {
+  GlState::BindBufferBase(GL_UNIFORM_BUFFER, binding_, buffer_.get());
+}
+
+void UniformBuffer::Upload(const void* data) {
+  GlState::BindBuffer(GL_UNIFORM_BUFFER, buffer_.get());
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, size_, data);
+}
+
+}
@@ -0,0 +1,263 @@
+#ifndef UNIFORM_BLOCK_H_
+#define UNIFORM_BLOCK_H_
+
+#include <glad/glad.h>  // include glad to get all the required OpenGL headers
+
+#include "gl_resources.h"
+#include "gl_state.h"
+#include "glsl_types.h"
+#include "program_reflection.h"
+#include "ring_buffer.h"
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace experimentgl {
+
+// std140 base alignment and size of each type a block member can have.
+// Types without a specialization cannot be block members.
+template <typename T>
+struct Std140Type;
+
+template <>
+struct Std140Type<float> {
+  static constexpr size_t kAlignment = 4, kSize = 4;
+  static constexpr GLenum kGlType = GL_FLOAT;
+};
+template <>
+struct Std140Type<int> {
+  static constexpr size_t kAlignment = 4, kSize = 4;
+  static constexpr GLenum kGlType = GL_INT;
+};
+template <>
+struct Std140Type<unsigned int> {
+  static constexpr size_t kAlignment = 4, kSize = 4;
+  static constexpr GLenum kGlType = GL_UNSIGNED_INT;
+};
+template <>
+struct Std140Type<Vec2> {
+  static constexpr size_t kAlignment = 8, kSize = 8;
+  static constexpr GLenum kGlType = GL_FLOAT_VEC2;
+};
+// A vec3 is aligned like a vec4 but only 12 bytes long, so a scalar may
+// follow it in the same 16 bytes.
+template <>
+struct Std140Type<Vec3> {
+  static constexpr size_t kAlignment = 16, kSize = 12;
+  static constexpr GLenum kGlType = GL_FLOAT_VEC3;
+};
+template <>
+struct Std140Type<Vec4> {
+  static constexpr size_t kAlignment = 16, kSize = 16;
+  static constexpr GLenum kGlType = GL_FLOAT_VEC4;
+};
+// Four vec4 columns.
+template <>
+struct Std140Type<Mat4> {
+  static constexpr size_t kAlignment = 16, kSize = 64;
+  static constexpr GLenum kGlType = GL_FLOAT_MAT4;
+};
+
+// 'T name[N]' in a block. std140 rounds the stride of array elements up to
+// 16 bytes, which a plain C++ array of floats or vec2s does not do.
+template <typename T, size_t N>
+struct Std140Array {
+  struct alignas(16) Element {
+    T value;
+  };
+  Element elements[N];
+
+  T& operator[](size_t i) { return elements[i].value; }
+  const T& operator[](size_t i) const { return elements[i].value; }
+};
+
+template <typename T, size_t N>
+struct Std140Type<Std140Array<T, N>> {
+  static constexpr size_t kAlignment = 16;
+  static constexpr size_t kSize = N * sizeof(typename Std140Array<T, N>::Element);
+  static constexpr GLenum kGlType = Std140Type<T>::kGlType;
+};
+
+// One member of a C++ block struct, as declared by STD140_MEMBER().
+struct Std140Member {
+  const char* name;
+  // Where the C++ compiler put the member, and how big it made it.
+  size_t offset;
+  size_t size;
+  // What std140 asks of its type.
+  size_t alignment;
+  size_t std140_size;
+  GLenum gl_type;
+};
+
+template <typename T>
+constexpr Std140Member MakeStd140Member(const char* name, size_t offset) {
+  return Std140Member{name, offset, sizeof(T), Std140Type<T>::kAlignment,
+                      Std140Type<T>::kSize, Std140Type<T>::kGlType};
+}
+
+#define STD140_MEMBER(Block, member) \
+  ::experimentgl::MakeStd140Member<decltype(Block::member)>(#member, offsetof(Block, member))
+
+// Describes the C++ struct 'Block' as a GLSL uniform block. Specialize it
+// next to the struct, naming the GLSL block and listing every member in
+// declaration order:
+//
+//   struct Material {
+//     Vec4 tint;
+//     Vec2 uv_scale;
+//     float brightness;
+//   };
+//   template <>
+//   struct experimentgl::UniformBlockLayout<Material> {
+//     static constexpr const char* kName = "Material";
+//     static constexpr Std140Member kMembers[] = {
+//       STD140_MEMBER(Material, tint),
+//       STD140_MEMBER(Material, uv_scale),
+//       STD140_MEMBER(Material, brightness),
+//     };
+//   };
+//
+// GLSL members have the same names, in a 'layout(std140) uniform Material'.
+template <typename Block>
+struct UniformBlockLayout;
+
+constexpr size_t Std140RoundUp(size_t offset, size_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+// True if every member of 'Block' sits at the offset std140 gives it and has
+// its std140 size. Fails on missing padding (two vec3s in a row need a float
+// in between), on members left out of the layout and on reordered ones.
+template <typename Block>
+constexpr bool IsStd140() {
+  size_t end = 0;
+  for (const Std140Member& member : UniformBlockLayout<Block>::kMembers) {
+    if (member.offset != Std140RoundUp(end, member.alignment) ||
+        member.size != member.std140_size) {
+      return false;
+    }
+    end = member.offset + member.size;
+  }
+  return true;
+}
+
+// Checks the driver's layout of block 'name' in a program against the C++
+// members: every active GLSL member must be listed, at the same offset and
+// with the same type, and the block must fit in 'size' bytes once rounded
+// up to a vec4, as std140 pads the end of a block. Prints each
+// mismatch. Returns false if the program has no such block, too.
+bool MatchesUniformBlock(const ProgramReflection& reflection, const char* name,
+                         const Std140Member* members, size_t member_count, size_t size);
+
+// A buffer holding one uniform block, bound to a binding point. Programs
+// read it through Shader::BindUniformBlock() with the same binding, so one
+// upload serves every program that declares the block.
+class UniformBuffer {
+ public:
+  // Rebinds the buffer to its binding point, in case it was taken over.
+  void Bind();
+  GLuint buffer() const { return buffer_.get(); }
+  GLuint binding() const { return binding_; }
+  // Size of the block, without the std140 tail padding.
+  GLsizeiptr size() const { return size_; }
+
+ protected:
+  UniformBuffer(GlBuffer buffer, GLuint binding, GLsizeiptr size)
+      : buffer_(std::move(buffer)), binding_(binding), size_(size) {}
+  // Creates a buffer for a 'size' byte block and binds it to 'binding'.
+  // Empty if 'binding' is beyond GL_MAX_UNIFORM_BUFFER_BINDINGS.
+  static GlBuffer CreateBuffer(GLuint binding, GLsizeiptr size);
+  // Replaces the whole block with one glBufferSubData.
+  void Upload(const void* data);
+
+ private:
+  GlBuffer buffer_;
+  GLuint binding_;
+  GLsizeiptr size_;
+};
+
+// UniformBuffer holding a 'Block', whose layout is checked against std140
+// at compile time.
+template <typename Block>
+class UniformBlock : public UniformBuffer {
+ public:
+  static_assert(std::is_standard_layout<Block>::value &&
+                std::is_trivially_copyable<Block>::value,
+                "uniform blocks are uploaded as raw bytes");
+  static_assert(IsStd140<Block>(),
+                "Block does not match its std140 layout; check padding and member order");
+
+  // nullptr if 'binding' is out of range.
+  static std::unique_ptr<UniformBlock> Create(GLuint binding) {
+    GlBuffer buffer = CreateBuffer(binding, sizeof(Block));
+    if (!buffer) {
+      return nullptr;
+    }
+    return std::unique_ptr<UniformBlock>(new UniformBlock(std::move(buffer), binding));
+  }
+  void Update(const Block& block) { Upload(&block); }
+
+ private:
+  UniformBlock(GlBuffer buffer, GLuint binding)
+      : UniformBuffer(std::move(buffer), binding, sizeof(Block)) {}
+};
+
+// Smallest offset step glBindBufferRange accepts for uniform buffers.
+GLsizeiptr UniformBufferOffsetAlignment();
+
+// Per-draw values of a 'Block', streamed through a RingBuffer. Each Bind()
+// appends a copy to this frame's region and points the binding at it with
+// glBindBufferRange, so a draw costs one memcpy and one bind however many
+// members the block has, and nothing waits on the GPU.
+template <typename Block>
+class UniformRing {
+ public:
+  static_assert(std::is_standard_layout<Block>::value &&
+                std::is_trivially_copyable<Block>::value,
+                "uniform blocks are uploaded as raw bytes");
+  static_assert(IsStd140<Block>(),
+                "Block does not match its std140 layout; check padding and member order");
+
+  // Room for 'blocks_per_frame' Bind() calls per frame. nullptr if the ring
+  // cannot be created.
+  static std::unique_ptr<UniformRing> Create(GLuint binding, int blocks_per_frame) {
+    GLsizeiptr alignment = UniformBufferOffsetAlignment();
+    // Every block starts on an aligned offset and is bound with its std140
+    // size, which pads the end to a vec4.
+    GLsizeiptr stride = Std140RoundUp(Std140RoundUp(sizeof(Block), 16), alignment);
+    std::unique_ptr<RingBuffer> ring = RingBuffer::Create(GL_UNIFORM_BUFFER, stride * blocks_per_frame);
+    if (ring == nullptr) {
+      return nullptr;
+    }
+    return std::unique_ptr<UniformRing>(new UniformRing(std::move(ring), binding, alignment));
+  }
+  // Call once per frame, before the first Bind().
+  void NextFrame() { ring_->NextFrame(); }
+  // Writes 'block' and binds it for the next draw. Returns false, binding
+  // nothing, if this frame's room is used up.
+  bool Bind(const Block& block) {
+    GLintptr offset;
+    if (!ring_->Write(&block, sizeof(Block), alignment_, &offset)) {
+      return false;
+    }
+    GlState::BindBufferRange(GL_UNIFORM_BUFFER, binding_, ring_->buffer(), offset,
+                             Std140RoundUp(sizeof(Block), 16));
+    return true;
+  }
+  GLuint binding() const { return binding_; }
+  const RingBuffer& ring() const { return *ring_; }
+
+ private:
+  UniformRing(std::unique_ptr<RingBuffer> ring, GLuint binding, GLsizeiptr alignment)
+      : ring_(std::move(ring)), binding_(binding), alignment_(alignment) {}
+
+  std::unique_ptr<RingBuffer> ring_;
+  GLuint binding_;
+  GLsizeiptr alignment_;
+};
+
+}
+#endif // UNIFORM_BLOCK_H_
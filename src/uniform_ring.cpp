@@ -0,0 +1,148 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "context.h"
+#include "gl_resources.h"
+#include "gl_state.h"
+#include "shader.h"
+#include "trace.h"
+#include "uniform_block.h"
+
+#include <iostream>
+#include <cmath>
+
+using experimentgl::Context;
+using experimentgl::ContextOptions;
+using experimentgl::GlBuffer;
+using experimentgl::GlState;
+using experimentgl::GlVertexArray;
+using experimentgl::ParseContextOptions;
+using experimentgl::Shader;
+using experimentgl::Std140Member;
+using experimentgl::UniformRing;
+using experimentgl::Vec2;
+using experimentgl::Vec4;
+
+void processInput(Context *context);
+
+// settings
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+// The uniform.cpp triangle, drawn GRID x GRID times with its own values each.
+const int GRID = 32;
+const int OBJECTS = GRID * GRID;
+// Binding point the Object block is read from.
+const unsigned int OBJECT_BINDING = 0;
+
+// Layout of the Object block in vertex_shaders/object.vs.
+struct Object {
+  Vec4 color;
+  Vec2 offset;
+  float scale;
+};
+
+template <>
+struct experimentgl::UniformBlockLayout<Object> {
+  static constexpr const char* kName = "Object";
+  static constexpr Std140Member kMembers[] = {
+    STD140_MEMBER(Object, color),
+    STD140_MEMBER(Object, offset),
+    STD140_MEMBER(Object, scale),
+  };
+};
+
+int main(int argc, char** argv)
+{
+    // Create the GL context: a GLFW window, or an offscreen FBO with --headless.
+    // --------------------------------------------------------------------------
+    ContextOptions options;
+    options.width = SCR_WIDTH;
+    options.height = SCR_HEIGHT;
+    options.title = "Experiments";
+    std::unique_ptr<Context> context = Context::Create(ParseContextOptions(argc, argv, options));
+    if (context == nullptr)
+    {
+        return -1;
+    }
+
+    float vertices[] = {
+      -0.25f, -0.25f, 0.0f,
+      0.0f, 0.25f, 0.0f,
+      0.25f, -0.25f, 0.0f,
+    };
+    GlVertexArray VAO = GlVertexArray::Create();
+    GlBuffer VBO = GlBuffer::Create();
+    GlState::BindVertexArray(VAO.get());
+    GlState::BindBuffer(GL_ARRAY_BUFFER, VBO.get());
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    VBO.SetBytes(sizeof(vertices));
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    std::unique_ptr<Shader> shader = Shader::Create("vertex_shaders/object.vs", "fragment_shaders/triangle.fs");
+    // Room for every object's block, three frames deep.
+    std::unique_ptr<UniformRing<Object>> objects = UniformRing<Object>::Create(OBJECT_BINDING, OBJECTS);
+    if (shader == nullptr || objects == nullptr || !shader->BindUniformBlock(*objects))
+    {
+        return -1;
+    }
+
+    // render loop
+    // -----------
+    while (!context->ShouldClose())
+    {
+        // input
+        // -----
+        {
+            TRACE_SCOPE("processInput");
+            processInput(context.get());
+        }
+
+        // Rendering commands here.
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        {
+            TRACE_SCOPE("draw submission");
+            float time = context->GetTime();
+            shader->use();
+            GlState::BindVertexArray(VAO.get());
+            // Each draw appends its block to this frame's part of the ring and
+            // binds it: one memcpy and one glBindBufferRange, no glUniform calls.
+            objects->NextFrame();
+            for (int i = 0; i < OBJECTS; ++i)
+            {
+                int row = i / GRID, column = i % GRID;
+                float green = (sin(time + 0.1f * i) / 2.0f) + 0.5f;
+                Object object = {{(float)column / GRID, green, (float)row / GRID, 1.0f},
+                                 {(column + 0.5f) * 2.0f / GRID - 1.0f, (row + 0.5f) * 2.0f / GRID - 1.0f},
+                                 2.0f / GRID};
+                // A full region binds nothing; drawing anyway would reuse the
+                // previous object's block.
+                if (!objects->Bind(object))
+                {
+                    std::cout << "Uniform ring full after " << i << " objects" << std::endl;
+                    break;
+                }
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+            }
+        }
+        // swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------------------------
+        context->SwapBuffers();
+        context->PollEvents();
+    }
+    std::cout << "uniform ring: " << (objects->ring().persistent() ? "persistent" : "glBufferSubData")
+              << ", " << objects->ring().stalls() << " stalls" << std::endl;
+
+    // The handles above delete their objects before the context goes away.
+    // The context terminates GLFW (or tears down EGL) when it goes out of scope.
+    return 0;
+}
+
+// process all input: query the context whether relevant keys are pressed/released this frame and react accordingly
+// ---------------------------------------------------------------------------------------------------------
+void processInput(Context *context)
+{
+    if(context->IsKeyPressed(GLFW_KEY_ESCAPE))
+        context->SetShouldClose();
+}
@@ -0,0 +1,245 @@
+#include "uniform_shadow.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace experimentgl {
+
+namespace {
+
+long staged_count = 0;
+long upload_count = 0;
+
+// Layout of one element of a uniform of GL type 'type'.
+struct UniformFormat {
+  // GL_FLOAT, GL_INT or GL_UNSIGNED_INT; bools and samplers are ints.
+  GLenum component;
+  // Components, or columns x rows for matrices.
+  int columns;
+  int rows;
+};
+
+UniformFormat uniform_format(GLenum type) {
+  switch (type) {
+    case GL_FLOAT: return {GL_FLOAT, 1, 1};
+    case GL_FLOAT_VEC2: return {GL_FLOAT, 2, 1};
+    case GL_FLOAT_VEC3: return {GL_FLOAT, 3, 1};
+    case GL_FLOAT_VEC4: return {GL_FLOAT, 4, 1};
+    case GL_INT: case GL_BOOL: return {GL_INT, 1, 1};
+    case GL_INT_VEC2: case GL_BOOL_VEC2: return {GL_INT, 2, 1};
+    case GL_INT_VEC3: case GL_BOOL_VEC3: return {GL_INT, 3, 1};
+    case GL_INT_VEC4: case GL_BOOL_VEC4: return {GL_INT, 4, 1};
+    case GL_UNSIGNED_INT: return {GL_UNSIGNED_INT, 1, 1};
+    case GL_UNSIGNED_INT_VEC2: return {GL_UNSIGNED_INT, 2, 1};
+    case GL_UNSIGNED_INT_VEC3: return {GL_UNSIGNED_INT, 3, 1};
+    case GL_UNSIGNED_INT_VEC4: return {GL_UNSIGNED_INT, 4, 1};
+    case GL_FLOAT_MAT2: return {GL_FLOAT, 2, 2};
+    case GL_FLOAT_MAT3: return {GL_FLOAT, 3, 3};
+    case GL_FLOAT_MAT4: return {GL_FLOAT, 4, 4};
+    case GL_FLOAT_MAT2x3: return {GL_FLOAT, 2, 3};
+    case GL_FLOAT_MAT2x4: return {GL_FLOAT, 2, 4};
+    case GL_FLOAT_MAT3x2: return {GL_FLOAT, 3, 2};
+    case GL_FLOAT_MAT3x4: return {GL_FLOAT, 3, 4};
+    case GL_FLOAT_MAT4x2: return {GL_FLOAT, 4, 2};
+    case GL_FLOAT_MAT4x3: return {GL_FLOAT, 4, 3};
+    // Samplers and images.
+    default: return {GL_INT, 1, 1};
+  }
+}
+
+// True if values of GL type 'value' can be staged for a uniform of GL type
+// 'uniform'. GL_BOOL values are ints, as GL takes them.
+bool accepts(GLenum uniform, GLenum value) {
+  if (uniform == value) {
+    return true;
+  }
+  UniformFormat format = uniform_format(uniform);
+  bool scalar_int = format.component == GL_INT && format.columns == 1 && format.rows == 1;
+  // int and bool, and samplers and images, which take texture units as ints.
+  return scalar_int && (value == GL_INT || value == GL_BOOL);
+}
+
+const char* type_name(GLenum type) {
+  switch (type) {
+    case GL_FLOAT: return "float";
+    case GL_FLOAT_VEC2: return "vec2";
+    case GL_FLOAT_VEC3: return "vec3";
+    case GL_FLOAT_VEC4: return "vec4";
+    case GL_INT: return "int";
+    case GL_INT_VEC2: return "ivec2";
+    case GL_INT_VEC3: return "ivec3";
+    case GL_INT_VEC4: return "ivec4";
+    case GL_BOOL: return "bool";
+    case GL_BOOL_VEC2: return "bvec2";
+    case GL_BOOL_VEC3: return "bvec3";
+    case GL_BOOL_VEC4: return "bvec4";
+    case GL_UNSIGNED_INT: return "uint";
+    case GL_UNSIGNED_INT_VEC2: return "uvec2";
+    case GL_UNSIGNED_INT_VEC3: return "uvec3";
+    case GL_UNSIGNED_INT_VEC4: return "uvec4";
+    case GL_FLOAT_MAT2: return "mat2";
+    case GL_FLOAT_MAT3: return "mat3";
+    case GL_FLOAT_MAT4: return "mat4";
+    case GL_FLOAT_MAT2x3: return "mat2x3";
+    case GL_FLOAT_MAT2x4: return "mat2x4";
+    case GL_FLOAT_MAT3x2: return "mat3x2";
+    case GL_FLOAT_MAT3x4: return "mat3x4";
+    case GL_FLOAT_MAT4x2: return "mat4x2";
+    case GL_FLOAT_MAT4x3: return "mat4x3";
+    default: return "sampler or image";
+  }
+}
+
+// The glUniform*v call for 'count' elements of 'type'.
+void upload(GLenum type, GLint location, GLsizei count, const void* data) {
+  const GLfloat* f = static_cast<const GLfloat*>(data);
+  const GLint* i = static_cast<const GLint*>(data);
+  const GLuint* u = static_cast<const GLuint*>(data);
+  switch (type) {
+    case GL_FLOAT: glUniform1fv(location, count, f); return;
+    case GL_FLOAT_VEC2: glUniform2fv(location, count, f); return;
+    case GL_FLOAT_VEC3: glUniform3fv(location, count, f); return;
+    case GL_FLOAT_VEC4: glUniform4fv(location, count, f); return;
+    case GL_INT_VEC2: case GL_BOOL_VEC2: glUniform2iv(location, count, i); return;
+    case GL_INT_VEC3: case GL_BOOL_VEC3: glUniform3iv(location, count, i); return;
+    case GL_INT_VEC4: case GL_BOOL_VEC4: glUniform4iv(location, count, i); return;
+    case GL_UNSIGNED_INT: glUniform1uiv(location, count, u); return;
+    case GL_UNSIGNED_INT_VEC2: glUniform2uiv(location, count, u); return;
+    case GL_UNSIGNED_INT_VEC3: glUniform3uiv(location, count, u); return;
+    case GL_UNSIGNED_INT_VEC4: glUniform4uiv(location, count, u); return;
+    case GL_FLOAT_MAT2: glUniformMatrix2fv(location, count, GL_FALSE, f); return;
+    case GL_FLOAT_MAT3: glUniformMatrix3fv(location, count, GL_FALSE, f); return;
+    case GL_FLOAT_MAT4: glUniformMatrix4fv(location, count, GL_FALSE, f); return;
+    case GL_FLOAT_MAT2x3: glUniformMatrix2x3fv(location, count, GL_FALSE, f); return;
+    case GL_FLOAT_MAT2x4: glUniformMatrix2x4fv(location, count, GL_FALSE, f); return;
+    case GL_FLOAT_MAT3x2: glUniformMatrix3x2fv(location, count, GL_FALSE, f); return;
+    case GL_FLOAT_MAT3x4: glUniformMatrix3x4fv(location, count, GL_FALSE, f); return;
+    case GL_FLOAT_MAT4x2: glUniformMatrix4x2fv(location, count, GL_FALSE, f); return;
+    case GL_FLOAT_MAT4x3: glUniformMatrix4x3fv(location, count, GL_FALSE, f); return;
+    // GL_INT, GL_BOOL, samplers and images.
+    default: glUniform1iv(location, count, i); return;
+  }
+}
+
+} // anonymous namespace.
+
+UniformShadow::UniformShadow(const ProgramReflection& reflection) {
+  size_t offset = 0;
+  GLint max_location = -1;
+  for (const ReflectedUniform& uniform : reflection.uniforms()) {
+    if (uniform.location < 0) {
+      continue;
+    }
+    UniformFormat format = uniform_format(uniform.type);
+    Entry entry;
+    entry.name = uniform.name;
+    entry.location = uniform.location;
+    entry.type = uniform.type;
+    entry.element_size = 4 * format.columns * format.rows;
+    entry.size = entry.element_size * uniform.size;
+    entry.offset = offset;
+    offset += entry.size;
+    max_location = std::max(max_location, uniform.location);
+    entries_.push_back(entry);
+  }
+  entry_of_location_.assign(max_location + 1, -1);
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    entry_of_location_[entries_[i].location] = i;
+  }
+  current_.resize(offset);
+  staged_.resize(offset);
+  dirty_.reserve(entries_.size());
+}
+
+void UniformShadow::Stage(GLint location, GLenum type, const void* data, size_t size) {
+  if (location < 0 || location >= static_cast<GLint>(entry_of_location_.size()) ||
+      entry_of_location_[location] < 0) {
+    return;
+  }
+  int index = entry_of_location_[location];
+  Entry& entry = entries_[index];
+  // upload() goes by the uniform's type, so anything else would reach GL
+  // reinterpreted or cut short.
+  if (!accepts(entry.type, type) || size % entry.element_size != 0) {
+    if (!entry.reported) {
+      std::cout << "Uniform " << entry.name << " is " << type_name(entry.type)
+                << ", not set from " << size << " bytes of " << type_name(type) << std::endl;
+      entry.reported = true;
+    }
+    return;
+  }
+  if (size == 0) {
+    return;
+  }
+  ++staged_count;
+  StageEntry(index, data, size);
+}
+
+void UniformShadow::CarryOver(const UniformShadow& previous) {
+  if (&previous == this) {
+    return;
+  }
+  for (const Entry& old : previous.entries_) {
+    const unsigned char* data;
+    size_t size;
+    if (old.dirty && old.staged_size > 0) {
+      data = &previous.staged_[old.offset];
+      size = old.staged_size;
+    } else if (old.known) {
+      data = &previous.current_[old.offset];
+      size = old.size;
+    } else {
+      continue;
+    }
+    for (size_t i = 0; i < entries_.size(); ++i) {
+      const Entry& entry = entries_[i];
+      // Values someone staged or uploaded on this program win.
+      if (entry.name == old.name && entry.type == old.type && !entry.dirty && !entry.known) {
+        StageEntry(i, data, size);
+        break;
+      }
+    }
+  }
+}
+
+void UniformShadow::StageEntry(int index, const void* data, size_t size) {
+  Entry& entry = entries_[index];
+  // No more than the array holds.
+  size = std::min(size, entry.size);
+  std::memcpy(&staged_[entry.offset], data, size);
+  entry.staged_size = size;
+  if (!entry.dirty) {
+    entry.dirty = true;
+    dirty_.push_back(index);
+  }
+}
+
+void UniformShadow::Commit() {
+  for (int index : dirty_) {
+    Entry& entry = entries_[index];
+    entry.dirty = false;
+    const unsigned char* staged = &staged_[entry.offset];
+    unsigned char* current = &current_[entry.offset];
+    if (entry.staged_size == 0 ||
+        (entry.known && std::memcmp(staged, current, entry.staged_size) == 0)) {
+      continue;
+    }
+    upload(entry.type, entry.location, entry.staged_size / entry.element_size, staged);
+    std::memcpy(current, staged, entry.staged_size);
+    // A partial array upload leaves the rest of 'current_' unknown.
+    entry.known = entry.staged_size == entry.size;
+    ++upload_count;
+  }
+  dirty_.clear();
+}
+
+long UniformShadow::staged() {
+  return staged_count;
+}
+
+long UniformShadow::uploads() {
+  return upload_count;
+}
+
+}
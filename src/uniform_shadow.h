@@ -0,0 +1,86 @@
+#ifndef UNIFORM_SHADOW_H_
+#define UNIFORM_SHADOW_H_
+
+#include <glad/glad.h>  // include glad to get all the required OpenGL headers
+
+#include "program_reflection.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace experimentgl {
+
+// Shadow copy of the plain (non-block) uniforms of one program. Values are
+// staged by Stage() and go up in Commit(), right before a draw, and only
+// if their bits differ from what the program already holds. Sets of the
+// same value every frame then cost a memcmp instead of a driver call.
+//
+// Uniform values are program state, so every user of a program must share
+// its shadow, or the copy goes stale.
+class UniformShadow {
+ public:
+  // Covers the uniforms of the program 'reflection' was taken from.
+  explicit UniformShadow(const ProgramReflection& reflection);
+
+  // Stages 'size' bytes for the uniform at 'location', as its glUniform*v
+  // call would take them: bools as ints, arrays as consecutive elements.
+  // 'type' is the GL type of one element of 'data' (GL_BOOL for bools held
+  // as ints). It must be the uniform's type, except that int and bool
+  // values set int and bool uniforms and samplers. Values of another type
+  // or not a whole number of elements are rejected and reported, once per
+  // uniform. Locations the program does not have are ignored, like in GL.
+  void Stage(GLint location, GLenum type, const void* data, size_t size);
+  // Uploads the staged values that changed to the program, which must be in
+  // use. Does not allocate.
+  void Commit();
+  // Stages the values 'previous' holds for uniforms of the same name and
+  // type, staged ones first, for uniforms this shadow has no value of its
+  // own for. A reloaded program starts from GL's defaults; this keeps the
+  // values its Shader set on the program it replaces.
+  void CarryOver(const UniformShadow& previous);
+  // True if Commit() has anything to look at.
+  bool dirty() const { return !dirty_.empty(); }
+
+  // Process-wide totals: values staged, and uploads that reached GL.
+  static long staged();
+  static long uploads();
+  // Stages that did not lead to an upload.
+  static long elided() { return staged() - uploads(); }
+
+ private:
+  struct Entry {
+    std::string name;
+    GLint location;
+    GLenum type;
+    // Bytes of one element and of the whole array.
+    size_t element_size;
+    size_t size;
+    // Where its bytes are in 'current_' and 'staged_'.
+    size_t offset;
+    // Bytes staged since the last commit, and whether it is in 'dirty_'.
+    size_t staged_size = 0;
+    bool dirty = false;
+    // False until something was uploaded: GL's defaults are not assumed.
+    bool known = false;
+    // Whether a rejected Stage() was reported already.
+    bool reported = false;
+  };
+
+  // Copies 'size' bytes into the staging area of entry 'index'. 'size' is
+  // a whole number of elements.
+  void StageEntry(int index, const void* data, size_t size);
+
+  std::vector<Entry> entries_;
+  // Location -> index into 'entries_', or -1. Array elements past the first
+  // map to -1: arrays are staged through their first location.
+  std::vector<int> entry_of_location_;
+  // Last uploaded and staged values, laid out per Entry::offset.
+  std::vector<unsigned char> current_;
+  std::vector<unsigned char> staged_;
+  // Entries to look at in Commit(); capacity for all of them is reserved.
+  std::vector<int> dirty_;
+};
+
+}
+#endif // UNIFORM_SHADOW_H_
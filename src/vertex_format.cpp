@@ -0,0 +1,146 @@
+#include "vertex_format.h"
+
+#include "gl_state.h"
+
+#include <iostream>
+#include <tuple>
+#include <utility>
+
+namespace experimentgl {
+
+namespace {
+
+// Components of a GLSL input type, and whether it is an integer type. 0 for
+// matrices, which take several locations and are not fed by one attribute.
+GLint glsl_components(GLenum type, bool* integer) {
+  *integer = false;
+  switch (type) {
+    case GL_FLOAT:
+      return 1;
+    case GL_FLOAT_VEC2:
+      return 2;
+    case GL_FLOAT_VEC3:
+      return 3;
+    case GL_FLOAT_VEC4:
+      return 4;
+    case GL_INT:
+    case GL_UNSIGNED_INT:
+      *integer = true;
+      return 1;
+    case GL_INT_VEC2:
+    case GL_UNSIGNED_INT_VEC2:
+      *integer = true;
+      return 2;
+    case GL_INT_VEC3:
+    case GL_UNSIGNED_INT_VEC3:
+      *integer = true;
+      return 3;
+    case GL_INT_VEC4:
+    case GL_UNSIGNED_INT_VEC4:
+      *integer = true;
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+const VertexAttribute* find_location(const VertexFormat& format, GLint location) {
+  for (size_t i = 0; i < format.count; ++i) {
+    if (static_cast<GLint>(format.attributes[i].location) == location) {
+      return &format.attributes[i];
+    }
+  }
+  return nullptr;
+}
+
+auto attribute_tuple(const VertexAttribute& a) {
+  return std::tie(a.location, a.type, a.components, a.normalized, a.integer, a.offset, a.size);
+}
+
+} // anonymous namespace.
+
+void SetVertexAttributes(const VertexFormat& format, GLuint buffer) {
+  GlState::BindBuffer(GL_ARRAY_BUFFER, buffer);
+  for (size_t i = 0; i < format.count; ++i) {
+    const VertexAttribute& a = format.attributes[i];
+    if (a.integer) {
+      glVertexAttribIPointer(a.location, a.components, a.type, format.stride, (void*)a.offset);
+    } else {
+      glVertexAttribPointer(a.location, a.components, a.type, a.normalized ? GL_TRUE : GL_FALSE,
+                            format.stride, (void*)a.offset);
+    }
+    glEnableVertexAttribArray(a.location);
+  }
+}
+
+bool MatchesVertexFormat(const ProgramReflection& reflection, const VertexFormat& format) {
+  bool matches = true;
+  for (const ReflectedAttribute& input : reflection.attributes()) {
+    // Built-ins such as gl_VertexID have no location.
+    if (input.location < 0) {
+      continue;
+    }
+    const VertexAttribute* attribute = find_location(format, input.location);
+    bool integer;
+    GLint components = glsl_components(input.type, &integer);
+    if (attribute == nullptr) {
+      std::cout << "Vertex input " << input.name << " at location " << input.location
+                << " is not in the vertex format" << std::endl;
+      matches = false;
+    } else if (attribute->components < components || attribute->integer != integer) {
+      std::cout << "Vertex input " << input.name << " has type 0x" << std::hex << input.type
+                << std::dec << ", its attribute " << attribute->name << " "
+                << attribute->components << (attribute->integer ? " integer" : " float")
+                << " components" << std::endl;
+      matches = false;
+    }
+  }
+  return matches;
+}
+
+bool VertexArrayCache::Key::operator<(const Key& other) const {
+  auto a = std::tie(buffer, element_buffer, format.stride, format.count);
+  auto b = std::tie(other.buffer, other.element_buffer, other.format.stride, other.format.count);
+  if (a != b) {
+    return a < b;
+  }
+  if (format.attributes == other.format.attributes) {
+    return false;
+  }
+  for (size_t i = 0; i < format.count; ++i) {
+    auto x = attribute_tuple(format.attributes[i]);
+    auto y = attribute_tuple(other.format.attributes[i]);
+    if (x != y) {
+      return x < y;
+    }
+  }
+  return false;
+}
+
+GLuint VertexArrayCache::Get(const VertexFormat& format, GLuint buffer, GLuint element_buffer) {
+  Key key{format, buffer, element_buffer};
+  auto it = arrays_.find(key);
+  if (it != arrays_.end()) {
+    ++hits_;
+    return it->second.get();
+  }
+  GlVertexArray vertex_array = GlVertexArray::Create();
+  GlState::BindVertexArray(vertex_array.get());
+  SetVertexAttributes(format, buffer);
+  if (element_buffer != 0) {
+    GlState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer);
+  }
+  return arrays_.emplace(key, std::move(vertex_array)).first->second.get();
+}
+
+void VertexArrayCache::Forget(GLuint buffer) {
+  for (auto it = arrays_.begin(); it != arrays_.end();) {
+    if (it->first.buffer == buffer || it->first.element_buffer == buffer) {
+      it = arrays_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+}
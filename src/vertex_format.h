@@ -0,0 +1,199 @@
+#ifndef VERTEX_FORMAT_H_
+#define VERTEX_FORMAT_H_
+
+#include <glad/glad.h>  // include glad to get all the required OpenGL headers
+
+#include "gl_resources.h"
+#include "glsl_types.h"
+#include "program_reflection.h"
+
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <type_traits>
+
+namespace experimentgl {
+
+// How GL fetches an attribute of C++ type T: the component type and count,
+// and whether integers are normalized to [0, 1] / [-1, 1] or read as
+// integers by an int/uint shader input. Specialize it for new types.
+template <typename T>
+struct VertexAttributeType;
+
+template <GLenum Type, GLint Components, bool Normalized = false, bool Integer = false>
+struct VertexFetch {
+  static constexpr GLenum kType = Type;
+  static constexpr GLint kComponents = Components;
+  static constexpr bool kNormalized = Normalized;
+  static constexpr bool kInteger = Integer;
+};
+
+template <> struct VertexAttributeType<float> : VertexFetch<GL_FLOAT, 1> {};
+template <> struct VertexAttributeType<Vec2> : VertexFetch<GL_FLOAT, 2> {};
+template <> struct VertexAttributeType<Vec3> : VertexFetch<GL_FLOAT, 3> {};
+template <> struct VertexAttributeType<Vec4> : VertexFetch<GL_FLOAT, 4> {};
+template <> struct VertexAttributeType<int> : VertexFetch<GL_INT, 1, false, true> {};
+template <> struct VertexAttributeType<unsigned> : VertexFetch<GL_UNSIGNED_INT, 1, false, true> {};
+
+// One member of a vertex struct, as declared by VERTEX_ATTRIBUTE().
+struct VertexAttribute {
+  // Shader input it feeds, e.g. "aPos".
+  const char* name;
+  GLuint location;
+  GLenum type;
+  GLint components;
+  bool normalized;
+  bool integer;
+  // Where the C++ compiler put the member, and how big it made it.
+  size_t offset;
+  size_t size;
+};
+
+template <typename T>
+constexpr VertexAttribute MakeVertexAttribute(const char* name, GLuint location, size_t offset) {
+  using Fetch = VertexAttributeType<T>;
+  return VertexAttribute{name, location, Fetch::kType, Fetch::kComponents, Fetch::kNormalized,
+                         Fetch::kInteger, offset, sizeof(T)};
+}
+
+#define VERTEX_ATTRIBUTE(Vertex, member, location, name)                              \
+  ::experimentgl::MakeVertexAttribute<decltype(Vertex::member)>(name, location, \
+                                                                offsetof(Vertex, member))
+
+// Describes the C++ struct 'Vertex' to GL. Specialize it next to the struct,
+// listing every member with the location and name of the shader input it
+// feeds:
+//
+//   struct TexturedVertex {
+//     Vec3 position;
+//     Vec2 uv;
+//   };
+//   template <>
+//   struct experimentgl::VertexLayout<TexturedVertex> {
+//     static constexpr VertexAttribute kAttributes[] = {
+//       VERTEX_ATTRIBUTE(TexturedVertex, position, 0, "aPos"),
+//       VERTEX_ATTRIBUTE(TexturedVertex, uv, 2, "aTexCoord"),
+//     };
+//   };
+template <typename Vertex>
+struct VertexLayout;
+
+// The minimum GL guarantees for GL_MAX_VERTEX_ATTRIBS and
+// GL_MAX_VERTEX_ATTRIB_STRIDE.
+const GLuint kMaxVertexAttributes = 16;
+const size_t kMaxVertexStride = 2048;
+
+// True if every attribute lies inside the vertex, starts on a 4-byte
+// boundary and has a location GL is sure to support.
+template <typename Vertex>
+constexpr bool VertexAttributesFit() {
+  for (const VertexAttribute& a : VertexLayout<Vertex>::kAttributes) {
+    if (a.offset % 4 != 0 || a.offset + a.size > sizeof(Vertex) ||
+        a.location >= kMaxVertexAttributes) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// True if no two attributes overlap or share a location.
+template <typename Vertex>
+constexpr bool VertexAttributesDisjoint() {
+  const auto& attributes = VertexLayout<Vertex>::kAttributes;
+  for (size_t i = 0; i < std::size(attributes); ++i) {
+    for (size_t j = i + 1; j < std::size(attributes); ++j) {
+      const VertexAttribute& a = attributes[i];
+      const VertexAttribute& b = attributes[j];
+      if (a.location == b.location ||
+          (a.offset < b.offset + b.size && b.offset < a.offset + a.size)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// True if the attributes account for every byte of the vertex: padding and
+// unlisted members would be fetched for nothing.
+template <typename Vertex>
+constexpr bool VertexAttributesCover() {
+  size_t size = 0;
+  for (const VertexAttribute& a : VertexLayout<Vertex>::kAttributes) {
+    size += a.size;
+  }
+  return size == sizeof(Vertex);
+}
+
+// A vertex layout with its stride, as handed to GL.
+struct VertexFormat {
+  const VertexAttribute* attributes;
+  size_t count;
+  GLsizei stride;
+};
+
+// The format of 'Vertex', whose layout is checked at compile time.
+template <typename Vertex>
+constexpr VertexFormat VertexFormatOf() {
+  static_assert(std::is_standard_layout<Vertex>::value &&
+                std::is_trivially_copyable<Vertex>::value,
+                "vertices are uploaded as raw bytes");
+  static_assert(sizeof(Vertex) % 4 == 0 && sizeof(Vertex) <= kMaxVertexStride,
+                "vertex stride must be a multiple of 4 bytes, at most 2048");
+  static_assert(VertexAttributesFit<Vertex>(),
+                "attribute outside the vertex, misaligned or with a location over 15");
+  static_assert(VertexAttributesDisjoint<Vertex>(), "attributes overlap or share a location");
+  static_assert(VertexAttributesCover<Vertex>(),
+                "vertex has padding or members without an attribute");
+  return VertexFormat{VertexLayout<Vertex>::kAttributes,
+                      std::size(VertexLayout<Vertex>::kAttributes), sizeof(Vertex)};
+}
+
+// Points the bound VAO's attributes at 'buffer' laid out as 'format', with
+// glVertexAttribPointer, or glVertexAttribIPointer for integer attributes.
+void SetVertexAttributes(const VertexFormat& format, GLuint buffer);
+
+// Checks a program's active attributes against 'format': each must be
+// listed at its location with at least as many components, and be an
+// integer attribute exactly when the shader input is an int or uint type.
+// Extra components are dropped by GL, which packed formats such as
+// GL_INT_2_10_10_10_REV rely on to feed a vec3. Prints each mismatch.
+// Attributes the shader does not use are fine.
+bool MatchesVertexFormat(const ProgramReflection& reflection, const VertexFormat& format);
+
+// VAOs set up by SetVertexAttributes(), one per (format, vertex buffer,
+// element buffer). Formats are compared by content, so vertex types with
+// the same layout share their VAOs. Asking again for a pair is a lookup
+// rather than a round of attribute calls.
+class VertexArrayCache {
+ public:
+  // The VAO reading 'buffer' as 'Vertex's and indices from 'element_buffer'
+  // (0 for none), set up on first use. Bindings afterwards are unspecified:
+  // setting up binds the new VAO and the buffers, a cache hit binds
+  // nothing. Bind explicitly through GlState before uploading or drawing.
+  template <typename Vertex>
+  GLuint Get(GLuint buffer, GLuint element_buffer = 0) {
+    return Get(VertexFormatOf<Vertex>(), buffer, element_buffer);
+  }
+  GLuint Get(const VertexFormat& format, GLuint buffer, GLuint element_buffer);
+  // Deletes the VAOs reading 'buffer'. Call before deleting the buffer: GL
+  // may hand its name out again.
+  void Forget(GLuint buffer);
+
+  size_t size() const { return arrays_.size(); }
+  // Get() calls answered from the cache.
+  long hits() const { return hits_; }
+
+ private:
+  struct Key {
+    VertexFormat format;
+    GLuint buffer;
+    GLuint element_buffer;
+    bool operator<(const Key& other) const;
+  };
+
+  std::map<Key, GlVertexArray> arrays_;
+  long hits_ = 0;
+};
+
+}
+#endif // VERTEX_FORMAT_H_
@@ -0,0 +1,383 @@
+#include "vertex_packing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace experimentgl {
+
+namespace {
+
+uint32_t float_bits(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+float bits_float(uint32_t bits) {
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Rounds to nearest even, as cvtps2dq does in the default rounding mode.
+int32_t round_even(float value) {
+  return static_cast<int32_t>(std::nearbyint(value));
+}
+
+float clamp_unit(float value, float lo) {
+  return std::max(lo, std::min(value, 1.0f));
+}
+
+// How a GL 4.2+ normalized signed integer of 'bits' bits reads back.
+float snorm_decode(int32_t value, int bits) {
+  return std::max(static_cast<float>(value) / ((1 << (bits - 1)) - 1), -1.0f);
+}
+
+// Values a little past the range come from rounding in FitPositions(), not
+// from data that really does not fit.
+const float kClampSlack = 1e-5f;
+
+void accumulate(PackingError* error, float original, float decoded) {
+  float difference = std::fabs(decoded - original);
+  error->max_error = std::max(error->max_error, difference);
+  error->sum_squared += static_cast<double>(difference) * difference;
+  ++error->components;
+}
+
+void store32(void* out, size_t stride, size_t i, uint32_t value) {
+  std::memcpy(static_cast<char*>(out) + i * stride, &value, sizeof(value));
+}
+
+uint32_t load32(const void* out, size_t stride, size_t i) {
+  uint32_t value;
+  std::memcpy(&value, static_cast<const char*>(out) + i * stride, sizeof(value));
+  return value;
+}
+
+// Position 'p' moved into the [-1, 1] box of 'dequant', one axis at a time
+// and in the same order of operations as the SSE2 path.
+float normalize(float p, float offset, float inverse_scale) {
+  return clamp_unit((p - offset) * inverse_scale, -1.0f);
+}
+
+Vec3 inverse(const Vec3& scale) {
+  return Vec3{1.0f / scale.x, 1.0f / scale.y, 1.0f / scale.z};
+}
+
+// Error of positions read back through 'decode', which gives the
+// normalized x, y and z of vertex i.
+template <typename Decode>
+PackingError position_error(const Vec3* positions, size_t count, const PositionDequant& dequant,
+                            Decode decode) {
+  PackingError error;
+  const float* scale = &dequant.scale.x;
+  const float* offset = &dequant.offset.x;
+  for (size_t i = 0; i < count; ++i) {
+    float n[3];
+    decode(i, n);
+    const float* p = &positions[i].x;
+    for (int axis = 0; axis < 3; ++axis) {
+      if (std::fabs((p[axis] - offset[axis]) / scale[axis]) > 1.0f + kClampSlack) {
+        ++error.clamped;
+      }
+      accumulate(&error, p[axis], n[axis] * scale[axis] + offset[axis]);
+    }
+  }
+  return error;
+}
+
+uint16_t pack_unorm8x4_scalar_component(float value) {
+  return static_cast<uint16_t>(round_even(clamp_unit(value, 0.0f) * 255.0f));
+}
+
+uint32_t pack_unorm8x4_scalar(const Vec3& c) {
+  return pack_unorm8x4_scalar_component(c.x) | pack_unorm8x4_scalar_component(c.y) << 8 |
+         pack_unorm8x4_scalar_component(c.z) << 16 | 255u << 24;
+}
+
+void pack_snorm16x4_scalar(const Vec3& p, const Vec3& offset, const Vec3& inverse_scale,
+                           void* out) {
+  int16_t packed[4] = {
+    static_cast<int16_t>(round_even(normalize(p.x, offset.x, inverse_scale.x) * 32767.0f)),
+    static_cast<int16_t>(round_even(normalize(p.y, offset.y, inverse_scale.y) * 32767.0f)),
+    static_cast<int16_t>(round_even(normalize(p.z, offset.z, inverse_scale.z) * 32767.0f)),
+    32767,
+  };
+  std::memcpy(out, packed, sizeof(packed));
+}
+
+uint32_t pack_snorm10x3_scalar(const Vec3& p, const Vec3& offset, const Vec3& inverse_scale) {
+  uint32_t x = round_even(normalize(p.x, offset.x, inverse_scale.x) * 511.0f);
+  uint32_t y = round_even(normalize(p.y, offset.y, inverse_scale.y) * 511.0f);
+  uint32_t z = round_even(normalize(p.z, offset.z, inverse_scale.z) * 511.0f);
+  return (x & 0x3ff) | (y & 0x3ff) << 10 | (z & 0x3ff) << 20 | 1u << 30;
+}
+
+#if defined(__SSE2__)
+
+// FloatToHalf() on four lanes; each result is in the low 16 bits of its
+// lane, with garbage above.
+__m128i float_to_half_sse2(__m128 value) {
+  const __m128 sign_mask = _mm_set1_ps(-0.0f);
+  // Magnitudes from 65520 up round to infinity.
+  const __m128i half_max = _mm_set1_epi32((127 + 16) << 23);
+  // Smallest float that is a normal half.
+  const __m128i min_normal = _mm_set1_epi32((127 - 14) << 23);
+  const __m128i subnormal_magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+  // Rebiases the exponent and adds the rounding bias of the mantissa.
+  const __m128i normal_bias = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+
+  __m128 sign = _mm_and_ps(value, sign_mask);
+  __m128 magnitude = _mm_xor_ps(value, sign);
+  __m128i bits = _mm_castps_si128(magnitude);
+
+  __m128i is_nan = _mm_castps_si128(_mm_cmpunord_ps(magnitude, magnitude));
+  __m128i inf_or_nan = _mm_or_si128(_mm_and_si128(is_nan, _mm_set1_epi32(0x200)),
+                                    _mm_set1_epi32(0x7c00));
+  __m128i is_finite = _mm_cmpgt_epi32(half_max, bits);
+  __m128i is_subnormal = _mm_cmpgt_epi32(min_normal, bits);
+
+  // Subnormals: let the float adder do the rounding.
+  __m128i subnormal = _mm_sub_epi32(
+      _mm_castps_si128(_mm_add_ps(magnitude, _mm_castsi128_ps(subnormal_magic))),
+      subnormal_magic);
+  // Normals: round to nearest even by adding 0xfff plus the lowest kept bit.
+  __m128i odd = _mm_srai_epi32(_mm_slli_epi32(bits, 31 - 13), 31);
+  __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(bits, normal_bias), odd), 13);
+
+  __m128i finite = _mm_or_si128(_mm_and_si128(is_subnormal, subnormal),
+                                _mm_andnot_si128(is_subnormal, normal));
+  __m128i half = _mm_or_si128(_mm_and_si128(is_finite, finite),
+                              _mm_andnot_si128(is_finite, inf_or_nan));
+  return _mm_or_si128(half, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+}
+
+// Normalized x, y, z of 'p' in lanes 0-2 and 'w' in lane 3. Vec3 arrays
+// have no padding, so 16-byte loads could run past the last one.
+__m128 load_normalized(const Vec3& p, __m128 offset, __m128 inverse_scale, float w) {
+  __m128 n = _mm_mul_ps(_mm_sub_ps(_mm_set_ps(w, p.z, p.y, p.x), offset), inverse_scale);
+  return _mm_max_ps(_mm_set1_ps(-1.0f), _mm_min_ps(n, _mm_set1_ps(1.0f)));
+}
+
+#endif
+
+} // anonymous namespace.
+
+uint16_t FloatToHalf(float value) {
+  uint32_t bits = float_bits(value);
+  uint32_t sign = bits & 0x80000000u;
+  bits ^= sign;
+  uint32_t half;
+  if (bits >= (127 + 16) << 23) {
+    // Too large for a half, infinity or NaN.
+    half = bits > 0x7f800000u ? 0x7e00 : 0x7c00;
+  } else if (bits < (127 - 14) << 23) {
+    // Subnormal or zero: let the float adder do the rounding.
+    const uint32_t magic = ((127 - 15) + (23 - 10) + 1) << 23;
+    half = float_bits(bits_float(bits) + bits_float(magic)) - magic;
+  } else {
+    uint32_t odd = (bits >> 13) & 1;
+    bits += 0xfff - ((127 - 15) << 23);
+    bits += odd;
+    half = bits >> 13;
+  }
+  return static_cast<uint16_t>(half | sign >> 16);
+}
+
+float HalfToFloat(uint16_t half) {
+  float sign = half & 0x8000 ? -1.0f : 1.0f;
+  int exponent = (half >> 10) & 0x1f;
+  int mantissa = half & 0x3ff;
+  if (exponent == 0) {
+    return sign * std::ldexp(static_cast<float>(mantissa), -24);
+  }
+  if (exponent == 31) {
+    return mantissa == 0 ? sign * INFINITY : NAN;
+  }
+  return sign * std::ldexp(static_cast<float>(mantissa | 0x400), exponent - 25);
+}
+
+PositionDequant FitPositions(const Vec3* positions, size_t count) {
+  if (count == 0) {
+    return PositionDequant{{1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f}};
+  }
+  Vec3 lo = positions[0];
+  Vec3 hi = positions[0];
+  for (size_t i = 1; i < count; ++i) {
+    lo = Vec3{std::min(lo.x, positions[i].x), std::min(lo.y, positions[i].y),
+              std::min(lo.z, positions[i].z)};
+    hi = Vec3{std::max(hi.x, positions[i].x), std::max(hi.y, positions[i].y),
+              std::max(hi.z, positions[i].z)};
+  }
+  // A flat axis still needs a nonzero scale to divide by.
+  auto half_extent = [](float lo, float hi) { return hi > lo ? (hi - lo) / 2 : 1.0f; };
+  return PositionDequant{
+    {half_extent(lo.x, hi.x), half_extent(lo.y, hi.y), half_extent(lo.z, hi.z)},
+    {(lo.x + hi.x) / 2, (lo.y + hi.y) / 2, (lo.z + hi.z) / 2},
+  };
+}
+
+double PackingError::rms() const {
+  return components > 0 ? std::sqrt(sum_squared / components) : 0.0;
+}
+
+void PackingError::Print(const char* name) const {
+  std::cout << name << ": max error " << max_error << ", rms " << rms() << ", " << clamped
+            << " clamped" << std::endl;
+}
+
+PackingError PackHalf2(const Vec2* values, size_t count, void* out, size_t stride) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  // Two values per register.
+  const __m128i low_half = _mm_set1_epi32(0xffff);
+  for (; i + 2 <= count; i += 2) {
+    __m128i halves = _mm_and_si128(float_to_half_sse2(_mm_loadu_ps(&values[i].x)), low_half);
+    // x | y << 16 in the low 32 bits of each 64-bit half.
+    __m128i packed = _mm_or_si128(halves, _mm_srli_epi64(halves, 16));
+    store32(out, stride, i, _mm_cvtsi128_si32(packed));
+    store32(out, stride, i + 1, _mm_cvtsi128_si32(_mm_srli_si128(packed, 8)));
+  }
+#endif
+  for (; i < count; ++i) {
+    store32(out, stride, i, FloatToHalf(values[i].x) | FloatToHalf(values[i].y) << 16);
+  }
+
+  PackingError error;
+  for (i = 0; i < count; ++i) {
+    uint32_t packed = load32(out, stride, i);
+    float decoded[2] = {HalfToFloat(packed & 0xffff), HalfToFloat(packed >> 16)};
+    const float* original = &values[i].x;
+    for (int c = 0; c < 2; ++c) {
+      if (std::isinf(decoded[c]) && !std::isinf(original[c])) {
+        ++error.clamped;
+      }
+      accumulate(&error, original[c], decoded[c]);
+    }
+  }
+  return error;
+}
+
+PackingError PackUnorm8x4(const Vec3* colors, size_t count, void* out, size_t stride) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  // Four colors per iteration, narrowed to bytes together.
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 max = _mm_set1_ps(255.0f);
+  auto quantize = [&](const Vec3& c) {
+    __m128 v = _mm_max_ps(zero, _mm_min_ps(_mm_set_ps(1.0f, c.z, c.y, c.x), one));
+    return _mm_cvtps_epi32(_mm_mul_ps(v, max));
+  };
+  for (; i + 4 <= count; i += 4) {
+    __m128i words = _mm_packs_epi32(quantize(colors[i]), quantize(colors[i + 1]));
+    __m128i words2 = _mm_packs_epi32(quantize(colors[i + 2]), quantize(colors[i + 3]));
+    __m128i bytes = _mm_packus_epi16(words, words2);
+    store32(out, stride, i, _mm_cvtsi128_si32(bytes));
+    store32(out, stride, i + 1, _mm_cvtsi128_si32(_mm_srli_si128(bytes, 4)));
+    store32(out, stride, i + 2, _mm_cvtsi128_si32(_mm_srli_si128(bytes, 8)));
+    store32(out, stride, i + 3, _mm_cvtsi128_si32(_mm_srli_si128(bytes, 12)));
+  }
+#endif
+  for (; i < count; ++i) {
+    store32(out, stride, i, pack_unorm8x4_scalar(colors[i]));
+  }
+
+  PackingError error;
+  for (i = 0; i < count; ++i) {
+    uint32_t packed = load32(out, stride, i);
+    const float* original = &colors[i].x;
+    for (int c = 0; c < 3; ++c) {
+      if (original[c] < -kClampSlack || original[c] > 1.0f + kClampSlack) {
+        ++error.clamped;
+      }
+      accumulate(&error, original[c], ((packed >> (8 * c)) & 0xff) / 255.0f);
+    }
+  }
+  return error;
+}
+
+PackingError PackSnorm16x4(const Vec3* positions, size_t count, const PositionDequant& dequant,
+                           void* out, size_t stride) {
+  Vec3 inverse_scale = inverse(dequant.scale);
+  size_t i = 0;
+#if defined(__SSE2__)
+  // Two positions per iteration. Lane 3 normalizes to 1.0 for w.
+  const __m128 offset = _mm_set_ps(0.0f, dequant.offset.z, dequant.offset.y, dequant.offset.x);
+  const __m128 scale = _mm_set_ps(1.0f, inverse_scale.z, inverse_scale.y, inverse_scale.x);
+  const __m128 max = _mm_set1_ps(32767.0f);
+  for (; i + 2 <= count; i += 2) {
+    __m128i q0 = _mm_cvtps_epi32(_mm_mul_ps(load_normalized(positions[i], offset, scale, 1.0f), max));
+    __m128i q1 =
+        _mm_cvtps_epi32(_mm_mul_ps(load_normalized(positions[i + 1], offset, scale, 1.0f), max));
+    __m128i shorts = _mm_packs_epi32(q0, q1);
+    char* base = static_cast<char*>(out);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(base + i * stride), shorts);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(base + (i + 1) * stride),
+                     _mm_srli_si128(shorts, 8));
+  }
+#endif
+  for (; i < count; ++i) {
+    pack_snorm16x4_scalar(positions[i], dequant.offset, inverse_scale,
+                          static_cast<char*>(out) + i * stride);
+  }
+
+  return position_error(positions, count, dequant, [&](size_t i, float* n) {
+    int16_t packed[4];
+    std::memcpy(packed, static_cast<const char*>(out) + i * stride, sizeof(packed));
+    for (int axis = 0; axis < 3; ++axis) {
+      n[axis] = snorm_decode(packed[axis], 16);
+    }
+  });
+}
+
+PackingError PackSnorm10x3(const Vec3* positions, size_t count, const PositionDequant& dequant,
+                           void* out, size_t stride) {
+  Vec3 inverse_scale = inverse(dequant.scale);
+  size_t i = 0;
+#if defined(__SSE2__)
+  // Four positions per iteration, transposed so each axis fills a register
+  // and the bit fields are assembled with plain shifts.
+  const __m128 offset = _mm_set_ps(0.0f, dequant.offset.z, dequant.offset.y, dequant.offset.x);
+  const __m128 scale = _mm_set_ps(0.0f, inverse_scale.z, inverse_scale.y, inverse_scale.x);
+  const __m128 max = _mm_set1_ps(511.0f);
+  const __m128i field = _mm_set1_epi32(0x3ff);
+  for (; i + 4 <= count; i += 4) {
+    __m128 x = load_normalized(positions[i], offset, scale, 0.0f);
+    __m128 y = load_normalized(positions[i + 1], offset, scale, 0.0f);
+    __m128 z = load_normalized(positions[i + 2], offset, scale, 0.0f);
+    __m128 w = load_normalized(positions[i + 3], offset, scale, 0.0f);
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    __m128i qx = _mm_and_si128(_mm_cvtps_epi32(_mm_mul_ps(x, max)), field);
+    __m128i qy = _mm_and_si128(_mm_cvtps_epi32(_mm_mul_ps(y, max)), field);
+    __m128i qz = _mm_and_si128(_mm_cvtps_epi32(_mm_mul_ps(z, max)), field);
+    __m128i packed = _mm_or_si128(
+        _mm_or_si128(qx, _mm_slli_epi32(qy, 10)),
+        _mm_or_si128(_mm_slli_epi32(qz, 20), _mm_set1_epi32(1 << 30)));
+    store32(out, stride, i, _mm_cvtsi128_si32(packed));
+    store32(out, stride, i + 1, _mm_cvtsi128_si32(_mm_srli_si128(packed, 4)));
+    store32(out, stride, i + 2, _mm_cvtsi128_si32(_mm_srli_si128(packed, 8)));
+    store32(out, stride, i + 3, _mm_cvtsi128_si32(_mm_srli_si128(packed, 12)));
+  }
+#endif
+  for (; i < count; ++i) {
+    store32(out, stride, i, pack_snorm10x3_scalar(positions[i], dequant.offset, inverse_scale));
+  }
+
+  return position_error(positions, count, dequant, [&](size_t i, float* n) {
+    uint32_t packed = load32(out, stride, i);
+    for (int axis = 0; axis < 3; ++axis) {
+      // Sign-extend the 10-bit field.
+      int32_t value = static_cast<int32_t>((packed >> (10 * axis)) << 22) >> 22;
+      n[axis] = snorm_decode(value, 10);
+    }
+  });
+}
+
+}
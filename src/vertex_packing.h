@@ -0,0 +1,100 @@
+#ifndef VERTEX_PACKING_H_
+#define VERTEX_PACKING_H_
+
+#include <glad/glad.h>  // include glad to get all the required OpenGL headers
+
+#include "glsl_types.h"
+#include "vertex_format.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace experimentgl {
+
+// Compact attribute types. GL expands each back to floats during vertex
+// fetch, so shaders declare the same vec2/vec3/vec4 inputs as for float
+// attributes; only the layout on the C++ side changes.
+
+// Two GL_HALF_FLOATs, e.g. texture coordinates. 4 bytes instead of 8.
+struct Half2 {
+  uint16_t x, y;
+};
+
+// Four GL_UNSIGNED_BYTEs normalized to [0, 1], e.g. colors. 4 bytes
+// instead of 12 for an RGB float color.
+struct Unorm8x4 {
+  uint8_t x, y, z, w;
+};
+
+// Four GL_SHORTs normalized to [-1, 1]. The fourth keeps the attribute on
+// a 4-byte boundary and is written as 1.0. 8 bytes instead of 12.
+struct Snorm16x4 {
+  int16_t x, y, z, w;
+};
+
+// GL_INT_2_10_10_10_REV normalized to [-1, 1]: x, y and z in 10 bits each
+// from the low end, w in the top 2 bits, written as 1.0. 4 bytes instead
+// of 12.
+struct Snorm10x3 {
+  uint32_t bits;
+};
+
+// Snorm16x4 and Snorm10x3 are packed for the signed normalized conversion
+// of GL 4.2 and later, max(c / (2^(b-1) - 1), -1), which hits -1, 0 and 1
+// exactly. GL 3.3 reads (2c + 1) / (2^b - 1) instead, so contexts drawing
+// them must be at least this version (ContextOptions::gl_major/gl_minor).
+const int kSnormGlMajor = 4;
+const int kSnormGlMinor = 2;
+
+template <> struct VertexAttributeType<Half2> : VertexFetch<GL_HALF_FLOAT, 2> {};
+template <> struct VertexAttributeType<Unorm8x4> : VertexFetch<GL_UNSIGNED_BYTE, 4, true> {};
+template <> struct VertexAttributeType<Snorm16x4> : VertexFetch<GL_SHORT, 4, true> {};
+template <> struct VertexAttributeType<Snorm10x3>
+    : VertexFetch<GL_INT_2_10_10_10_REV, 4, true> {};
+
+// Maps mesh positions into the [-1, 1] range of snorm attributes. The
+// vertex shader undoes it with 'position * scale + offset'.
+struct PositionDequant {
+  Vec3 scale;
+  Vec3 offset;
+};
+
+// The dequant that stretches the bounding box of 'positions' over [-1, 1]
+// on every axis, which spends all the bits of the packed format on the
+// mesh.
+PositionDequant FitPositions(const Vec3* positions, size_t count);
+
+// How far the packed values land from the originals, in the units of the
+// originals, measured by decoding what was written the way GL does (for
+// snorm formats, the GL 4.2+ rule above).
+struct PackingError {
+  float max_error = 0;
+  double sum_squared = 0;
+  // Components compared, and how many were outside the format's range and
+  // got clamped.
+  size_t components = 0;
+  size_t clamped = 0;
+
+  double rms() const;
+  // Prints "<name>: max ..., rms ..., N clamped".
+  void Print(const char* name) const;
+};
+
+// The encoders convert 'count' values and write them 'stride' bytes apart
+// starting at 'out', so each one fills one member of an array of packed
+// vertices. They use SSE2 where it is available and agree bit for bit with
+// the scalar path used elsewhere.
+PackingError PackHalf2(const Vec2* values, size_t count, void* out, size_t stride);
+// Colors in [0, 1]; alpha is written as 1.0.
+PackingError PackUnorm8x4(const Vec3* colors, size_t count, void* out, size_t stride);
+PackingError PackSnorm16x4(const Vec3* positions, size_t count, const PositionDequant& dequant,
+                           void* out, size_t stride);
+PackingError PackSnorm10x3(const Vec3* positions, size_t count, const PositionDequant& dequant,
+                           void* out, size_t stride);
+
+// IEEE half <-> float, rounding to nearest even.
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t half);
+
+}
+#endif // VERTEX_PACKING_H_
@@ -0,0 +1,16 @@
+#version 330 core
+#include "vertex_attributes.glsl"
+
+// Per-draw values, streamed through a UniformRing.
+layout(std140) uniform Object {
+  vec4 color;
+  vec2 offset;
+  float scale;
+};
+
+out vec3 ourColor;
+
+void main() {
+  gl_Position = vec4(aPos * scale + vec3(offset, 0.0f), 1.0f);
+  ourColor = color.rgb;
+}
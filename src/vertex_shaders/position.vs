@@ -0,0 +1,6 @@
+#version 330 core
+#include "vertex_attributes.glsl"
+
+void main() {
+  gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);
+}
@@ -1,6 +1,5 @@
 #version 330 core
-layout (location=0) in vec3 aPos;
-layout (location=1) in vec3 aColor;
+#include "vertex_attributes.glsl"
 
 out vec3 ourColor;
 uniform float rightShiftOffset;
@@ -1,6 +1,5 @@
 #version 330 core
-layout (location=0) in vec3 aPos;
-layout (location=1) in vec3 aColor;
+#include "vertex_attributes.glsl"
 layout (location=2) in vec2 aTexCoord;
 
 out vec3 ourColor;
@@ -0,0 +1,16 @@
+#version 330 core
+#include "vertex_attributes.glsl"
+layout (location=2) in vec2 aTexCoord;
+
+// Positions arrive normalized to [-1, 1]; this maps them back.
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+
+out vec3 ourColor;
+out vec2 texCoord;
+
+void main() {
+  gl_Position = vec4(aPos * positionScale + positionOffset, 1.0);
+  ourColor = aColor;
+  texCoord = aTexCoord;
+}
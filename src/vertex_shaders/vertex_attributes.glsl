@@ -0,0 +1,3 @@
+// Attribute locations shared by the vertex shaders.
+layout (location=0) in vec3 aPos;
+layout (location=1) in vec3 aColor;
@@ -0,0 +1,54 @@
+#include "vertex_stream.h"
+
+#include "gl_state.h"
+
+#include <utility>
+
+namespace experimentgl {
+
+std::unique_ptr<VertexStream> VertexStream::Create(const VertexFormat& format,
+                                                   GLsizei vertices_per_frame) {
+  // Regions are whole vertices, so every batch starts on a vertex boundary.
+  std::unique_ptr<RingBuffer> ring = RingBuffer::Create(
+      GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(format.stride) * vertices_per_frame);
+  if (ring == nullptr) {
+    return nullptr;
+  }
+  std::unique_ptr<VertexStream> stream(
+      new VertexStream(std::move(ring), GlVertexArray::Create(), format.stride));
+  GlState::BindVertexArray(stream->vertex_array());
+  SetVertexAttributes(format, stream->ring_->buffer());
+  if (!stream->ring_->persistent()) {
+    stream->staging_.resize(stream->ring_->region_size());
+  }
+  return stream;
+}
+
+void VertexStream::NextFrame() {
+  ring_->NextFrame();
+}
+
+void* VertexStream::Begin(GLsizei count) {
+  pending_size_ = static_cast<GLsizeiptr>(stride_) * count;
+  pending_offset_ = -1;
+  if (ring_->persistent()) {
+    return ring_->Allocate(pending_size_, stride_, &pending_offset_);
+  }
+  if (pending_size_ > ring_->region_size() - ring_->used()) {
+    return nullptr;
+  }
+  return staging_.data();
+}
+
+bool VertexStream::End(GLint* first) {
+  if (pending_offset_ < 0 &&
+      (ring_->persistent() ||
+       !ring_->Write(staging_.data(), pending_size_, stride_, &pending_offset_))) {
+    return false;
+  }
+  *first = pending_offset_ / stride_;
+  pending_offset_ = -1;
+  return true;
+}
+
+}
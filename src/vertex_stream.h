@@ -0,0 +1,69 @@
+#ifndef VERTEX_STREAM_H_
+#define VERTEX_STREAM_H_
+
+#include <glad/glad.h>  // include glad to get all the required OpenGL headers
+
+#include "gl_resources.h"
+#include "ring_buffer.h"
+#include "vertex_format.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace experimentgl {
+
+// Vertices regenerated every frame, streamed through a GL_ARRAY_BUFFER
+// RingBuffer. One VAO points at the whole ring and is set up once; a batch
+// is drawn from the first vertex End() hands back, so nothing is created,
+// re-specified or allocated per frame.
+//
+//   auto stream = VertexStream::Create<Vertex>(3);
+//   ...
+//   Vertex* v = static_cast<Vertex*>(stream->Begin(3));
+//   ... fill v[0..2] ...
+//   GLint first;
+//   if (stream->End(&first)) glDrawArrays(GL_TRIANGLES, first, 3);
+class VertexStream {
+ public:
+  // Room for 'vertices_per_frame' 'Vertex'es each frame, with the VAO set
+  // up from its VertexLayout. Returns nullptr if the ring cannot be created.
+  template <typename Vertex>
+  static std::unique_ptr<VertexStream> Create(GLsizei vertices_per_frame) {
+    return Create(VertexFormatOf<Vertex>(), vertices_per_frame);
+  }
+  static std::unique_ptr<VertexStream> Create(const VertexFormat& format,
+                                              GLsizei vertices_per_frame);
+
+  // Moves on to the next frame's region. Call once per frame before Begin().
+  void NextFrame();
+  // Where to write the next 'count' vertices: the persistently mapped ring
+  // itself, or a staging area without buffer storage. nullptr if this
+  // frame's region has no room left.
+  void* Begin(GLsizei count);
+  // Finishes the vertices written since Begin() and stores the index of the
+  // first one in 'first'. Returns false if they did not fit.
+  bool End(GLint* first);
+
+  GLuint vertex_array() const { return vertex_array_.get(); }
+  GLsizei stride() const { return stride_; }
+  const RingBuffer& ring() const { return *ring_; }
+
+ private:
+  VertexStream(std::unique_ptr<RingBuffer> ring, GlVertexArray vertex_array, GLsizei stride)
+      : ring_(std::move(ring)), vertex_array_(std::move(vertex_array)), stride_(stride) {}
+
+  std::unique_ptr<RingBuffer> ring_;
+  GlVertexArray vertex_array_;
+  GLsizei stride_;
+  // Only used without buffer storage: one frame of vertices, copied into the
+  // ring by End().
+  std::vector<char> staging_;
+  // Batch between Begin() and End(): its size in bytes, and where it went
+  // in the ring when it was written there directly.
+  GLsizeiptr pending_size_ = 0;
+  GLintptr pending_offset_ = -1;
+};
+
+}
+#endif // VERTEX_STREAM_H_